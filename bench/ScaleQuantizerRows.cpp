@@ -0,0 +1,236 @@
+/*
+* Times one row of ScaleQuantizer2 at 16 channels for each hold mode, comparing the per-channel loop that decided the
+* hold mode on every channel of every sample with the processRow<HoldMode> instances in src/ScaleQuantizerMkII.cpp.
+* The row loops and the quantiser (music::getPitchFromVolts in the Ionian scale) are copied here so that the bench
+* builds without the Rack SDK, keep them in step with the module.
+*
+*	g++ -O3 -std=c++11 -o sq-bench bench/ScaleQuantizerRows.cpp && ./sq-bench
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+
+static const int CHANNELS = 16;
+static const int STEPS = 1 << 20;
+static const int CLOCK = 32; // Samples between hold triggers
+
+static int ASCALE_IONIAN[8] = {0, 2, 4, 5, 7, 9, 11, 12};
+
+static float getPitchFromVolts(float inVolts, int currRoot) {
+
+	int *curScaleArr = ASCALE_IONIAN;
+	int notesInScale = 8;
+
+	int octave = floor(inVolts);
+	float closestVal = 10.0;
+	float closestDist = 10.0;
+
+	float octaveOffset = 0;
+	if (currRoot != 0) {
+		octaveOffset = (12 - currRoot) / 12.0;
+	}
+
+	float fOctave = (float)octave - octaveOffset;
+	int scaleIndex = 0;
+	int searchOctave = 0;
+
+	do {
+		int degree = curScaleArr[scaleIndex];
+		float fVoltsAboveOctave = searchOctave + degree / 12.0;
+		float fScaleNoteInVolts = fOctave + fVoltsAboveOctave;
+		float distAway = fabs(inVolts - fScaleNoteInVolts);
+
+		if (distAway >= closestDist) {
+			break;
+		} else {
+			closestVal = fScaleNoteInVolts;
+			closestDist = distAway;
+		}
+
+		scaleIndex++;
+
+		if (scaleIndex == notesInScale - 1) {
+			scaleIndex = 0;
+			searchOctave++;
+		}
+	} while (true);
+
+	return closestVal;
+
+}
+
+enum HoldMode {
+	HOLD_NONE,
+	HOLD_COMMON,
+	HOLD_CHANNEL,
+	HOLD_CHANNEL_MONO
+};
+
+struct Row {
+
+	int currRoot = 0;
+
+	float in[CHANNELS];
+	float out[CHANNELS];
+
+	bool holdState[CHANNELS];
+	float holdPitch[CHANNELS];
+	float lastPitch[CHANNELS];
+	float lastInput[CHANNELS];
+	float pulse[CHANNELS];
+
+	Row() {
+		std::fill(in, in + CHANNELS, 0.0f);
+		std::fill(holdPitch, holdPitch + CHANNELS, 0.0f);
+		std::fill(lastPitch, lastPitch + CHANNELS, 0.0f);
+		std::fill(lastInput, lastInput + CHANNELS, NAN);
+		std::fill(pulse, pulse + CHANNELS, 0.0f);
+	}
+
+	// The loop before the hold modes were split out
+	void processBefore(int nCVChannels, int nHoldChannels, uint32_t held, float offset) {
+		int nChannels = std::max(nCVChannels, nHoldChannels);
+		for (int j = 0; j < nChannels; j++) {
+
+			holdState[j] = (held >> j) & 1;
+
+			if (nHoldChannels == 0) {
+				holdPitch[j] = getPitchFromVolts(in[j], currRoot);
+			} else if (nHoldChannels == 1) {
+				if (holdState[0]) {
+					holdPitch[j] = getPitchFromVolts(in[j], currRoot);
+				}
+			} else {
+				if (nCVChannels == 1) {
+					if (holdState[j]) {
+						holdPitch[j] = getPitchFromVolts(in[0], currRoot);
+					}
+				} else {
+					if (holdState[j]) {
+						holdPitch[j] = getPitchFromVolts(in[j], currRoot);
+					}
+				}
+			}
+
+			if (lastPitch[j] != holdPitch[j]) {
+				lastPitch[j] = holdPitch[j];
+				pulse[j] = 1e-3f;
+			}
+
+			out[j] = holdPitch[j] + offset;
+
+		}
+	}
+
+	template <HoldMode MODE>
+	void processRow(int nChannels, uint32_t held, float offset) {
+		for (int j = 0; j < nChannels; j++) {
+
+			bool sample;
+			switch (MODE) {
+				case HOLD_NONE:		sample = true; break;
+				case HOLD_COMMON:	sample = held & 1; break;
+				default:			sample = (held >> j) & 1;
+			}
+
+			float v = in[MODE == HOLD_CHANNEL_MONO ? 0 : j];
+			if (sample && v != lastInput[j]) {
+				lastInput[j] = v;
+				holdPitch[j] = getPitchFromVolts(v, currRoot);
+			}
+
+			if (lastPitch[j] != holdPitch[j]) {
+				lastPitch[j] = holdPitch[j];
+				pulse[j] = 1e-3f;
+			}
+
+			out[j] = holdPitch[j] + offset;
+
+		}
+	}
+
+};
+
+struct Case {
+	const char *name;
+	HoldMode mode;
+	int nCVChannels;
+	int nHoldChannels;
+};
+
+static float sink = 0.0f;
+
+// CV that moves every sample, or sits on a voltage
+static void setInput(Row &row, int step, bool moving) {
+	for (int j = 0; j < CHANNELS; j++) {
+		row.in[j] = moving ? (float)((step * 7 + j * 131) % 5000) / 1000.0f : 0.1f * j;
+	}
+}
+
+static uint32_t heldAt(int step, int nHoldChannels) {
+	if (nHoldChannels == 0 || step % CLOCK) {
+		return 0;
+	}
+	return nHoldChannels == 1 ? 1 : (1u << nHoldChannels) - 1;
+}
+
+template <HoldMode MODE>
+static double timeAfter(const Case &c, bool moving) {
+	Row row;
+	int nChannels = std::max(c.nCVChannels, c.nHoldChannels);
+	auto start = std::chrono::steady_clock::now();
+	for (int step = 0; step < STEPS; step++) {
+		setInput(row, step, moving);
+		row.processRow<MODE>(nChannels, heldAt(step, c.nHoldChannels), 0.0f);
+		sink += row.out[step & (CHANNELS - 1)];
+	}
+	std::chrono::duration<double, std::nano> t = std::chrono::steady_clock::now() - start;
+	return t.count() / STEPS;
+}
+
+static double timeBefore(const Case &c, bool moving) {
+	Row row;
+	auto start = std::chrono::steady_clock::now();
+	for (int step = 0; step < STEPS; step++) {
+		setInput(row, step, moving);
+		row.processBefore(c.nCVChannels, c.nHoldChannels, heldAt(step, c.nHoldChannels), 0.0f);
+		sink += row.out[step & (CHANNELS - 1)];
+	}
+	std::chrono::duration<double, std::nano> t = std::chrono::steady_clock::now() - start;
+	return t.count() / STEPS;
+}
+
+static double timeAfter(const Case &c, bool moving) {
+	switch (c.mode) {
+		case HOLD_NONE:		return timeAfter<HOLD_NONE>(c, moving);
+		case HOLD_COMMON:	return timeAfter<HOLD_COMMON>(c, moving);
+		case HOLD_CHANNEL:	return timeAfter<HOLD_CHANNEL>(c, moving);
+		default:			return timeAfter<HOLD_CHANNEL_MONO>(c, moving);
+	}
+}
+
+int main() {
+
+	const Case cases[] = {
+		{"HOLD_NONE",			HOLD_NONE,			CHANNELS,	0},
+		{"HOLD_COMMON",			HOLD_COMMON,		CHANNELS,	1},
+		{"HOLD_CHANNEL",		HOLD_CHANNEL,		CHANNELS,	CHANNELS},
+		{"HOLD_CHANNEL_MONO",	HOLD_CHANNEL_MONO,	1,			CHANNELS},
+	};
+
+	printf("ns per row, %d channels, hold triggers every %d samples\n", CHANNELS, CLOCK);
+	printf("%-18s %-7s %8s %8s\n", "mode", "cv", "before", "after");
+	for (const Case &c : cases) {
+		for (int moving = 1; moving >= 0; moving--) {
+			double before = timeBefore(c, moving);
+			double after = timeAfter(c, moving);
+			printf("%-18s %-7s %8.1f %8.1f\n", c.name, moving ? "moving" : "steady", before, after);
+		}
+	}
+
+	return sink == 12345.0f;
+
+}
@@ -1,33 +1,86 @@
 #include "AHCommon.hpp"
 
+#include <list>
 #include <sstream>
+#include <thread>
+#include <osdialog.h>
 
 namespace ah {
 
 namespace gui {
 
+static const char *fontPaths[NUM_FONTS] = {
+	"res/EurostileBold.ttf",
+	"res/DSEG14ClassicMini-BoldItalic.ttf"
+};
+
+static const char *svgPaths[NUM_SVGS] = {
+	"res/ComponentLibrary/AHButton.svg",
+	"res/ComponentLibrary/AHKnob.svg",
+	"res/ComponentLibrary/AHBigKnob.svg",
+	"res/ComponentLibrary/AHTrimpot.svg"
+};
+
+// Widgets are only created on the UI thread, so the caches are not locked
+std::shared_ptr<Font> getFont(FontId id) {
+	static std::shared_ptr<Font> fonts[NUM_FONTS];
+	if (!fonts[id]) {
+		fonts[id] = APP->window->loadFont(asset::plugin(pluginInstance, fontPaths[id]));
+	}
+	return fonts[id];
+}
+
+std::shared_ptr<Svg> getSvg(SvgId id) {
+	static std::shared_ptr<Svg> svgs[NUM_SVGS];
+	if (!svgs[id]) {
+		svgs[id] = APP->window->loadSvg(asset::plugin(pluginInstance, svgPaths[id]));
+	}
+	return svgs[id];
+}
+
 AHChoice::AHChoice() {
 	box.size = mm2px(math::Vec(0, 28.0 / 3)); // FIX
-	font = APP->window->loadFont(asset::plugin(pluginInstance, "res/EurostileBold.ttf")); // FIX
+	font = getFont(FONT_EUROSTILE); // FIX
 	color = nvgRGB(0x00, 0xFF, 0xFF);
 	bgColor = nvgRGBAf(30, 30, 30, 0); 
 	textOffset = math::Vec(10, 18);	// FIX?
 	fontSize = 12.0;
+
+	label = new Label;
+	label->choice = this;
+	cache = new DisplayCache(label);
+	addChild(cache);
 }
 
-void AHChoice::draw(NVGcontext *vg) {
-	nvgScissor(vg, 0, 0, box.size.x, box.size.y);
+void AHChoice::draw(const DrawArgs &args) {
+	// The size is set after construction, the cache must cover the choice before it is culled
+	label->box.size = box.size;
+	cache->box.size = box.size;
+	Widget::draw(args);
+}
 
-	if (font->handle >= 0) {
-		nvgFillColor(vg, color);
-		nvgFontFaceId(vg, font->handle);
-		nvgTextLetterSpacing(vg, 0.0);
+bool AHChoice::Label::snapshot() {
+	if (text == choice->text && !memcmp(&color, &choice->color, sizeof(NVGcolor))) {
+		return false;
+	}
+	text = choice->text;
+	color = choice->color;
+	return true;
+}
 
-		nvgFontSize(vg, fontSize); // FIX
-		nvgText(vg, textOffset.x, textOffset.y, text.c_str(), NULL);
+void AHChoice::Label::draw(const DrawArgs &args) {
+	nvgScissor(args.vg, 0, 0, box.size.x, box.size.y);
+
+	if (choice->font->handle >= 0) {
+		nvgFillColor(args.vg, color);
+		nvgFontFaceId(args.vg, choice->font->handle);
+		nvgTextLetterSpacing(args.vg, 0.0);
+
+		nvgFontSize(args.vg, choice->fontSize); // FIX
+		nvgText(args.vg, choice->textOffset.x, choice->textOffset.y, text.c_str(), NULL);
 	}
 
-	nvgResetScissor(vg);
+	nvgResetScissor(args.vg);
 }
 
 float Y_KNOB[2] =		{50.8, 56.0}; // w.r.t 22 = 28.8 from bottom
@@ -143,61 +196,221 @@ void calculateKeyboard(int inKey, float spacing, float xOff, float yOff, float *
 
 }
 
+Menu *SeedMenu::createChildMenu() {
+
+	struct FreeRunningItem : MenuItem {
+		digital::SeedRequest *request;
+		void onAction(const rack::event::Action &e) override {
+			request->post(digital::SeedRequest::FREE_RUNNING);
+		}
+	};
+
+	struct NewSeedItem : MenuItem {
+		digital::SeedRequest *request;
+		void onAction(const rack::event::Action &e) override {
+			request->post(digital::SeedRequest::FIXED_SEED, random::u64());
+		}
+	};
+
+	struct RestartItem : MenuItem {
+		digital::SeedRequest *request;
+		void onAction(const rack::event::Action &e) override {
+			request->post(digital::SeedRequest::RESTART);
+		}
+	};
+
+	Menu *menu = new Menu;
+
+	FreeRunningItem *freeItem = createMenuItem<FreeRunningItem>("Free running", CHECKMARK(!rng->fixed));
+	freeItem->request = request;
+	menu->addChild(freeItem);
+
+	NewSeedItem *seedItem = createMenuItem<NewSeedItem>(rng->fixed ? "New fixed seed" : "Fixed seed", 
+		rng->fixed ? string::f("%016llx", (unsigned long long)rng->fixedSeed) : "");
+	seedItem->request = request;
+	menu->addChild(seedItem);
+
+	RestartItem *restartItem = createMenuItem<RestartItem>("Restart sequence");
+	restartItem->request = request;
+	restartItem->disabled = !rng->fixed;
+	menu->addChild(restartItem);
+
+	return menu;
+}
+
 } // namespace gui
 
 namespace digital {
 
-double gaussrand() {
- 	static double U, V;
- 	static int phase = 0;
- 	double Z;
+// Inverse CDF of the standard normal at evenly spaced probabilities between those of -2 and 2,
+// so that any draw outside those probabilities clamps to the ends of the table
+struct ClampedNormalTable {
+
+	const static int SIZE = 1024;
+
+	float quantile[SIZE + 1];
+	float pLow;
+	float scale;
+
+	static double cdf(double x) {
+		return 0.5 * std::erfc(-x / std::sqrt(2.0));
+	}
+
+	ClampedNormalTable() {
+		double low = cdf(-2.0);
+		double high = cdf(2.0);
+		for (int i = 0; i <= SIZE; i++) {
+			double p = low + (high - low) * i / SIZE;
+			double a = -2.0;
+			double b = 2.0;
+			for (int j = 0; j < 48; j++) {
+				double mid = 0.5 * (a + b);
+				if (cdf(mid) < p) {
+					a = mid;
+				} else {
+					b = mid;
+				}
+			}
+			quantile[i] = 0.5 * (a + b);
+		}
+		pLow = low;
+		scale = SIZE / (high - low);
+	}
+
+	float lookup(float u) const {
+		float x = clamp((u - pLow) * scale, 0.0f, (float)SIZE);
+		int i = std::min((int)x, SIZE - 1);
+		float frac = x - i;
+		return quantile[i] + (quantile[i + 1] - quantile[i]) * frac;
+	}
+
+};
+
+static const ClampedNormalTable clampedNormalTable;
+
+float clampedNormal(Random &rng) {
+	return clampedNormalTable.lookup(rng.uniform());
+}
 
- 	if(phase == 0) {
- 		U = (rand() + 1.) / (RAND_MAX + 2.);
- 		V = rand() / (RAND_MAX + 1.);
- 		Z = sqrt(-2 * log(U)) * sin(2 * core::PI * V);
- 	} else
- 		Z = sqrt(-2 * log(U)) * cos(2 * core::PI * V);
+void clampedNormals(Random &rng, float *out, int n) {
+	for (int i = 0; i < n; i++) {
+		out[i] = clampedNormalTable.lookup(rng.uniform());
+	}
+}
 
- 	phase = 1 - phase;
+json_t *Random::toJson() {
+	json_t *rootJ = json_object();
 
- 	return Z;
+	json_object_set_new(rootJ, "fixed", json_boolean(fixed));
+	json_object_set_new(rootJ, "seed", json_string(string::f("%016llx", (unsigned long long)fixedSeed).c_str()));
+
+	if (fixed) {
+		json_t *stateJ = json_array();
+		for (int i = 0; i < 2; i++) {
+			json_array_append_new(stateJ, json_string(string::f("%016llx", (unsigned long long)state[i]).c_str()));
+		}
+		json_object_set_new(rootJ, "state", stateJ);
+	}
+
+	return rootJ;
 }
 
-} // digital
+void Random::fromJson(json_t *rootJ) {
+
+	json_t *fixedJ = json_object_get(rootJ, "fixed");
+	json_t *seedJ = json_object_get(rootJ, "seed");
+	if (!json_is_true(fixedJ)) {
+		setFreeRunning();
+		return;
+	}
+	if (!json_is_string(seedJ)) {
+		return;
+	}
+
+	setFixedSeed(strtoull(json_string_value(seedJ), NULL, 16));
+
+	// Resume where the sequence was saved, unless the state has been edited out
+	json_t *stateJ = json_object_get(rootJ, "state");
+	json_t *s0J = json_array_get(stateJ, 0);
+	json_t *s1J = json_array_get(stateJ, 1);
+	if (json_is_string(s0J) && json_is_string(s1J)) {
+		uint64_t s0 = strtoull(json_string_value(s0J), NULL, 16);
+		uint64_t s1 = strtoull(json_string_value(s1J), NULL, 16);
+		if (s0 || s1) {
+			state[0] = s0;
+			state[1] = s1;
+		}
+	}
+
+}
+
+} // namespace digital
 
 namespace music {
 
 Chord::Chord() : rootNote(0), quality(0), chord(0), modeDegree(0), inversion(0), octave(0) {
-	setVoltages(defaultChord.formula, 12);
+	getVoltsFromChord(defaultChord.formula.data(), rootNote, octave, 12, outVolts, NULL);
 }
 
-void Chord::setVoltages(int *chordArray, int offset) {
-	for (int j = 0; j < 6; j++) {
-		if (chordArray[j] < 0) {
-			int off = offset;
-			if (offset == 0) { // if offset = 0, randomise offset per note
-				off = (rand() % 3 + 1) * 12;
-			}
-			outVolts[j] = getVoltsFromPitch(chordArray[j] + off,rootNote) + octave;
-		} else {
-			outVolts[j] = getVoltsFromPitch(chordArray[j],	  rootNote) + octave;
-		}	
+void Chord::setVoltages(int *chordArray, int offset, digital::Random &rng) {
+	getVoltsFromChord(chordArray, rootNote, octave, offset, outVolts, &rng);
+}
+
+void Chord::setVoltages(std::vector<int> &chordArray, int offset, digital::Random &rng) {
+	getVoltsFromChord(chordArray.data(), rootNote, octave, offset, outVolts, &rng);
+}
+
+json_t *Chord::toJson() {
+	json_t *rootJ = json_object();
+
+	json_object_set_new(rootJ, "root", json_integer(rootNote));
+	json_object_set_new(rootJ, "quality", json_integer(quality));
+	json_object_set_new(rootJ, "chord", json_integer(chord));
+	json_object_set_new(rootJ, "degree", json_integer(modeDegree));
+	json_object_set_new(rootJ, "inversion", json_integer(inversion));
+	json_object_set_new(rootJ, "octave", json_integer(octave));
+
+	json_t *voltsJ = json_array();
+	for (int i = 0; i < 6; i++) {
+		json_array_append_new(voltsJ, json_real(outVolts[i]));
 	}
+	json_object_set_new(rootJ, "volts", voltsJ);
+
+	return rootJ;
 }
 
-void Chord::setVoltages(std::vector<int> &chordArray, int offset) {
-	for (int j = 0; j < 6; j++) {
-		if (chordArray[j] < 0) {
-			int off = offset;
-			if (offset == 0) { // if offset = 0, randomise offset per note
-				off = (rand() % 3 + 1) * 12;
-			}
-			outVolts[j] = getVoltsFromPitch(chordArray[j] + off,rootNote) + octave;
-		} else {
-			outVolts[j] = getVoltsFromPitch(chordArray[j],	  rootNote) + octave;
-		}	
+// Leaves the chord untouched unless every field is present
+bool Chord::fromJson(json_t *rootJ) {
+
+	json_t *rootNoteJ = json_object_get(rootJ, "root");
+	json_t *qualityJ = json_object_get(rootJ, "quality");
+	json_t *chordJ = json_object_get(rootJ, "chord");
+	json_t *degreeJ = json_object_get(rootJ, "degree");
+	json_t *inversionJ = json_object_get(rootJ, "inversion");
+	json_t *octaveJ = json_object_get(rootJ, "octave");
+	json_t *voltsJ = json_object_get(rootJ, "volts");
+	if (!json_is_integer(rootNoteJ) || !json_is_integer(qualityJ) || !json_is_integer(chordJ) || !json_is_integer(degreeJ) ||
+		!json_is_integer(inversionJ) || !json_is_integer(octaveJ) || json_array_size(voltsJ) != 6) {
+		return false;
+	}
+
+	for (int i = 0; i < 6; i++) {
+		if (!json_is_number(json_array_get(voltsJ, i))) {
+			return false;
+		}
 	}
+
+	rootNote = json_integer_value(rootNoteJ);
+	quality = json_integer_value(qualityJ);
+	chord = json_integer_value(chordJ);
+	modeDegree = json_integer_value(degreeJ);
+	inversion = json_integer_value(inversionJ);
+	octave = json_integer_value(octaveJ);
+	for (int i = 0; i < 6; i++) {
+		outVolts[i] = json_number_value(json_array_get(voltsJ, i));
+	}
+
+	return true;
 }
 
 
@@ -571,16 +784,6 @@ std::string NoteDegreeModeNames[12][7][7] = { // Note, Degree, Mode
 {"G#","G#","G","G#","G#","G","G"},
 {"A#","A","A","A#","A","A","A"}}};
 
-int ModeQuality[7][7] {
-	{MAJ,MIN,MIN,MAJ,MAJ,MIN,DIM}, // Ionian
-	{MIN,MIN,MAJ,MAJ,MIN,DIM,MAJ}, // Dorian
-	{MIN,MAJ,MAJ,MIN,DIM,MAJ,MIN}, // Phrygian
-	{MAJ,MAJ,MIN,DIM,MAJ,MIN,MIN}, // Lydian
-	{MAJ,MIN,DIM,MAJ,MIN,MIN,MAJ}, // Mixolydian
-	{MIN,DIM,MAJ,MIN,MIN,MAJ,MAJ}, // Aeolian
-	{DIM,MAJ,MIN,MIN,MAJ,MAJ,MIN}  // Locrian
-};
-
 int ModeOffset[7][7] {
 	{0,0,0,0,0,0,0},		// Ionian
 	{0,0,-1,0,0,0,-1},		// Dorian
@@ -601,24 +804,6 @@ std::string DegreeString[7][7] {
 	{"i°","bII","biii","iv","bV","bVI","bvii"} 	// Locrian
 };
 
-//0	1	2	3	4	5	6	7	8	9	10	11	12
-int tonicIndex[13] {1, 3, 5, 0, 2, 4, 6, 1, 3, 5, 0, 2, 4};
-int scaleIndex[7] {5, 3, 1, 6, 4, 2, 0};
-int noteIndex[13] { 
-	NOTE_G_FLAT,
-	NOTE_D_FLAT,
-	NOTE_A_FLAT,
-	NOTE_E_FLAT,
-	NOTE_B_FLAT,
-	NOTE_F,
-	NOTE_C,
-	NOTE_G,
-	NOTE_D,
-	NOTE_A,
-	NOTE_E,
-	NOTE_B,
-	NOTE_G_FLAT};
-
 int CIRCLE_FIFTHS [12] = {
 	NOTE_C,
 	NOTE_G,
@@ -664,6 +849,69 @@ int ASCALE_MINOR_PENTA		[6] = {0, 3, 5, 7, 10, 12};							// 1,b3,4,5,b7
 int ASCALE_HARMONIC_MINOR	[8] = {0, 2, 3, 5, 7, 8, 11, 12};					// 1,2,b3,4,5,b6,7
 int ASCALE_BLUES			[7] = {0, 3, 5, 6, 7, 10, 12};						// 1,b3,4,b5,5,b7
 
+PitchClassSet PitchClassSet::fromNotes(const int *notes, int n) {
+	int bits = 0;
+	for (int i = 0; i < n; i++) {
+		bits |= 1 << eucMod(notes[i], 12);
+	}
+	return PitchClassSet(bits);
+}
+
+int PitchClassSet::nth(int i) const {
+	int n = size();
+	if (n == 0) {
+		return 0;
+	}
+	int k = eucMod(i, n);
+	int octave = (i - k) / n;
+	unsigned int b = bits;
+	for (int j = 0; j < k; j++) {
+		b &= b - 1; // Drop the lowest member
+	}
+	return octave * 12 + __builtin_ctz(b);
+}
+
+PitchClassSet PitchClassSet::triad(int i) const {
+	int root = nth(i);
+	return PitchClassSet((1 << 0) | (1 << (nth(i + 2) - root)) | (1 << (nth(i + 4) - root)));
+}
+
+int getTriadQuality(PitchClassSet triad) {
+	if (triad.contains(4)) {
+		return MAJ;
+	}
+	if (triad.contains(3) && triad.contains(6) && !triad.contains(7)) {
+		return DIM;
+	}
+	return MIN;
+}
+
+PitchClassSet ScaleSets[NUM_SCALES] = {
+	PitchClassSet::fromNotes(ASCALE_CHROMATIC, LENGTHOF(ASCALE_CHROMATIC)),
+	PitchClassSet::fromNotes(ASCALE_IONIAN, LENGTHOF(ASCALE_IONIAN)),
+	PitchClassSet::fromNotes(ASCALE_DORIAN, LENGTHOF(ASCALE_DORIAN)),
+	PitchClassSet::fromNotes(ASCALE_PHRYGIAN, LENGTHOF(ASCALE_PHRYGIAN)),
+	PitchClassSet::fromNotes(ASCALE_LYDIAN, LENGTHOF(ASCALE_LYDIAN)),
+	PitchClassSet::fromNotes(ASCALE_MIXOLYDIAN, LENGTHOF(ASCALE_MIXOLYDIAN)),
+	PitchClassSet::fromNotes(ASCALE_AEOLIAN, LENGTHOF(ASCALE_AEOLIAN)),
+	PitchClassSet::fromNotes(ASCALE_LOCRIAN, LENGTHOF(ASCALE_LOCRIAN)),
+	PitchClassSet::fromNotes(ASCALE_MAJOR_PENTA, LENGTHOF(ASCALE_MAJOR_PENTA)),
+	PitchClassSet::fromNotes(ASCALE_MINOR_PENTA, LENGTHOF(ASCALE_MINOR_PENTA)),
+	PitchClassSet::fromNotes(ASCALE_HARMONIC_MINOR, LENGTHOF(ASCALE_HARMONIC_MINOR)),
+	PitchClassSet::fromNotes(ASCALE_BLUES, LENGTHOF(ASCALE_BLUES))
+};
+
+// The church modes are the rotations of the major scale
+PitchClassSet ModeSets[NUM_MODES] = {
+	ScaleSets[SCALE_IONIAN].mode(MODE_IONIAN),
+	ScaleSets[SCALE_IONIAN].mode(MODE_DORIAN),
+	ScaleSets[SCALE_IONIAN].mode(MODE_PHRYGIAN),
+	ScaleSets[SCALE_IONIAN].mode(MODE_LYDIAN),
+	ScaleSets[SCALE_IONIAN].mode(MODE_MIXOLYDIAN),
+	ScaleSets[SCALE_IONIAN].mode(MODE_AEOLIAN),
+	ScaleSets[SCALE_IONIAN].mode(MODE_LOCRIAN)
+};
+
 /*
 * Convert a root note (relative to C, C=0) and positive semi-tone offset from that root to a voltage (1V/OCT, 0V = C4 (or 3??))
 */
@@ -832,28 +1080,22 @@ float getPitchFromVolts(float inVolts, float inRoot, float inScale, int *outRoot
 }
 
 void getRootFromMode(int inMode, int inRoot, int inTonic, int *currRoot, int *quality) {
+	*currRoot = eucMod(inRoot + ModeSets[inMode].nth(inTonic), 12);
+	*quality = getTriadQuality(ModeSets[inMode].triad(inTonic));
+}
 
-	*quality = ModeQuality[inMode][inTonic];
-
-	int positionRelativeToStartOfScale = tonicIndex[inMode + inTonic];
-	int positionStartOfScale = scaleIndex[inMode];
-
-	int root = inRoot + noteIndex[positionStartOfScale + positionRelativeToStartOfScale]; 
-	*currRoot = eucMod(root, 12);
-
-	// Quantizer q;
-	//
-	// std::cout << "Mode: " << inMode
-	// 	<< " Root: " << q.noteNames[inRoot]
-	// 	<< " Tonic: " << q.tonicNames[inTonic]
-	// 	<< " Scale Pos: " << positionStartOfScale
-	// 	<< " Rel Pos: " <<  positionRelativeToStartOfScale
-	// 	<< " Note Index: " << positionStartOfScale + positionRelativeToStartOfScale
-	// 	<< " Note: " << noteIndex[positionStartOfScale + positionRelativeToStartOfScale]
-	// 	<< " Offset: " << ModeOffset[inMode][inTonic]
-	// 	<< " Output: " << *currRoot
-	// 	<< " " << q.noteNames[*currRoot]
-	// 	<< std::endl;
+void getVoltsFromChord(const int *chordArray, int rootNote, int octave, int offset, float *outVolts, digital::Random *rng) {
+	for (int j = 0; j < 6; j++) {
+		if (chordArray[j] < 0) {
+			int off = offset;
+			if (offset == 0) { // if offset = 0, randomise offset per note
+				off = (rng->range(3) + 1) * 12;
+			}
+			outVolts[j] = getVoltsFromPitch(chordArray[j] + off,rootNote) + octave;
+		} else {
+			outVolts[j] = getVoltsFromPitch(chordArray[j],	  rootNote) + octave;
+		}	
+	}
 }
 
 std::string InversionDefinition::getName(int rootNote) {
@@ -914,6 +1156,117 @@ KnownChords::KnownChords() {
 	}
 }
 
+ChordIndex::ChordIndex() {
+	for (size_t c = 0; c < BasicChordSet.size(); c++) {
+		const std::vector<int> &formula = BasicChordSet[c].root;
+		PitchClassSet notes = PitchClassSet::fromNotes(formula.data(), formula.size());
+
+		// The n-th distinct pitch class of the formula in the bass is the n-th inversion
+		int seen = 0;
+		int inversion = 0;
+		for (size_t i = 0; i < formula.size(); i++) {
+			int bass = eucMod(formula[i], 12);
+			if (seen & (1 << bass)) {
+				continue;
+			}
+			seen |= 1 << bass;
+
+			Entry &entry = entries[notes.transpose(-bass).bits >> 1];
+			if (entry.chord < 0) {
+				entry.chord = c;
+				entry.root = eucMod(-bass, 12);
+				entry.inversion = inversion;
+			}
+			inversion++;
+		}
+	}
+}
+
+ChordIndex chordIndex;
+
+json_t *DegreeTransitions::toJson() {
+	json_t *rootJ = json_object();
+	json_t *degrees_array = json_array();
+
+	for (int from = 0; from <= NUM_DEGREES; from++) {
+		json_t *row_array = json_array();
+		for (int to = 0; to < NUM_DEGREES; to++) {
+			json_array_append_new(row_array, json_real(weights[from][to]));
+		}
+		json_array_append_new(degrees_array, row_array);
+	}
+
+	json_object_set_new(rootJ, "degrees", degrees_array);
+	return rootJ;
+}
+
+bool DegreeTransitions::fromJson(json_t *rootJ) {
+
+	json_t *degrees_array = json_object_get(rootJ, "degrees");
+	if (!json_is_array(degrees_array)) {
+		return false;
+	}
+
+	size_t nRows = json_array_size(degrees_array);
+	if (nRows != NUM_DEGREES && nRows != NUM_DEGREES + 1) {
+		return false;
+	}
+
+	// Validate before touching anything
+	for (size_t from = 0; from < nRows; from++) {
+		json_t *row_array = json_array_get(degrees_array, from);
+		if (json_array_size(row_array) != NUM_DEGREES) {
+			return false;
+		}
+		for (int to = 0; to < NUM_DEGREES; to++) {
+			json_t *weightJ = json_array_get(row_array, to);
+			if (!json_is_number(weightJ) || json_number_value(weightJ) < 0.0) {
+				return false;
+			}
+		}
+	}
+
+	for (int from = 0; from <= NUM_DEGREES; from++) {
+		// If there is no row for chords from outside the mode, any degree is equally likely
+		json_t *row_array = ((size_t)from < nRows) ? json_array_get(degrees_array, from) : NULL;
+		for (int to = 0; to < NUM_DEGREES; to++) {
+			weights[from][to] = row_array ? json_number_value(json_array_get(row_array, to)) : 1.0f;
+		}
+	}
+
+	return true;
+}
+
+bool DegreeTransitions::load(const char *path) {
+
+	FILE *file = fopen(path, "r");
+	if (!file) {
+		WARN("Could not load transition matrix file %s", path);
+		return false;
+	}
+	DEFER({
+		fclose(file);
+	});
+
+	json_error_t error;
+	json_t *rootJ = json_loadf(file, 0, &error);
+	if (!rootJ) {
+		std::string message = string::f("File is not a valid transition matrix file. JSON parsing error at %s %d:%d %s", error.source, error.line, error.column, error.text);
+		osdialog_message(OSDIALOG_WARNING, OSDIALOG_OK, message.c_str());
+		return false;
+	}
+	DEFER({
+		json_decref(rootJ);
+	});
+
+	if (!fromJson(rootJ)) {
+		osdialog_message(OSDIALOG_WARNING, OSDIALOG_OK, "File is not a valid transition matrix file. Expected \"degrees\" to hold 7 or 8 rows of 7 non-negative weights");
+		return false;
+	}
+
+	return true;
+}
+
 void KnownChords::dump() {
 	for(ChordDefinition chord: chords) {
 		std::cout << chord.id << " = " << chord.name << std::endl;
@@ -930,6 +1283,277 @@ void KnownChords::dump() {
 	}
 }
 
+bool CompiledScale::compile(const std::string &scaleName, std::vector<float> pitchList, float scalePeriod) {
+
+	if (scalePeriod <= 0.0f) {
+		return false;
+	}
+
+	// Fold into one period, in order and without duplicates
+	for (size_t i = 0; i < pitchList.size(); i++) {
+		pitchList[i] = pitchList[i] - std::floor(pitchList[i] / scalePeriod) * scalePeriod;
+	}
+	std::sort(pitchList.begin(), pitchList.end());
+	pitchList.erase(std::unique(pitchList.begin(), pitchList.end()), pitchList.end());
+
+	int n = pitchList.size();
+	if (n == 0 || n > MAX_PITCHES - 2) {
+		return false;
+	}
+
+	// The nearest pitch may be the last of the period below or the first of the period above
+	pitches[0] = pitchList[n - 1] - scalePeriod;
+	for (int i = 0; i < n; i++) {
+		pitches[i + 1] = pitchList[i];
+	}
+	pitches[n + 1] = pitchList[0] + scalePeriod;
+
+	for (int i = 0; i < MAX_PITCHES; i++) {
+		bounds[i] = (i <= n) ? (pitches[i] + pitches[i + 1]) * 0.5f : INFINITY;
+	}
+
+	name = scaleName;
+	period = scalePeriod;
+	size = n;
+	return true;
+
+}
+
+float CompiledScale::quantise(float inVolts, int root) const {
+
+	float rootVolts = root / 12.0f;
+	float x = inVolts - rootVolts;
+	float periods = std::floor(x / period);
+	float r = x - periods * period;
+
+	// Number of bounds at or below r, which is the index of the nearest pitch
+	int k = 0;
+	for (int step = MAX_PITCHES / 2; step > 0; step /= 2) {
+		k += (bounds[k + step - 1] <= r) ? step : 0;
+	}
+
+	return rootVolts + periods * period + pitches[k];
+
+}
+
+// Scala file, see http://www.huygens-fokker.org/scala/scl_format.html. The 1/1 is implicit and the last pitch is the period
+static bool parseScala(const std::string &path, std::string &name, std::vector<float> &pitches, float &period) {
+
+	FILE *file = fopen(path.c_str(), "r");
+	if (!file) {
+		return false;
+	}
+	DEFER({
+		fclose(file);
+	});
+
+	std::vector<std::string> lines;
+	char buffer[256];
+	while (fgets(buffer, sizeof(buffer), file)) {
+		std::string line = string::trim(buffer);
+		if (line.size() > 0 && line[0] == '!') {
+			continue;
+		}
+		lines.push_back(line);
+	}
+
+	if (lines.size() < 2) {
+		return false;
+	}
+
+	// Keep the filename if there is no description
+	if (!lines[0].empty()) {
+		name = lines[0];
+	}
+	int n = atoi(lines[1].c_str());
+	if (n < 1 || (int)lines.size() < n + 2) {
+		return false;
+	}
+
+	pitches.clear();
+	pitches.push_back(0.0f);
+	for (int i = 0; i < n; i++) {
+
+		const std::string &line = lines[i + 2];
+		float volts;
+
+		if (line.find('.') != std::string::npos) { // Cents
+			volts = atof(line.c_str()) / 1200.0f;
+		} else { // Ratio or integer
+			int num = 0;
+			int den = 1;
+			if (sscanf(line.c_str(), "%d/%d", &num, &den) < 1 || num <= 0 || den <= 0) {
+				return false;
+			}
+			volts = std::log2((float)num / den);
+		}
+
+		if (i == n - 1) {
+			period = volts;
+		} else {
+			pitches.push_back(volts);
+		}
+
+	}
+
+	return true;
+
+}
+
+// JSON file of the form {"name": "...", "pitches": [0, 2, 3.5, ...], "period": 12} in semitones above the root, period defaults to 12
+static bool parseJsonScale(const std::string &path, std::string &name, std::vector<float> &pitches, float &period) {
+
+	FILE *file = fopen(path.c_str(), "r");
+	if (!file) {
+		return false;
+	}
+	DEFER({
+		fclose(file);
+	});
+
+	json_error_t error;
+	json_t *rootJ = json_loadf(file, 0, &error);
+	if (!rootJ) {
+		WARN("Could not parse scale %s: %s %d:%d %s", path.c_str(), error.source, error.line, error.column, error.text);
+		return false;
+	}
+	DEFER({
+		json_decref(rootJ);
+	});
+
+	json_t *nameJ = json_object_get(rootJ, "name");
+	if (json_is_string(nameJ)) {
+		name = json_string_value(nameJ);
+	}
+
+	json_t *pitchesJ = json_object_get(rootJ, "pitches");
+	if (!json_is_array(pitchesJ)) {
+		return false;
+	}
+
+	pitches.clear();
+	for (size_t i = 0; i < json_array_size(pitchesJ); i++) {
+		json_t *pitchJ = json_array_get(pitchesJ, i);
+		if (!json_is_number(pitchJ)) {
+			return false;
+		}
+		pitches.push_back(json_number_value(pitchJ) / 12.0f);
+	}
+
+	period = 1.0f;
+	json_t *periodJ = json_object_get(rootJ, "period");
+	if (json_is_number(periodJ)) {
+		period = json_number_value(periodJ) / 12.0f;
+	}
+
+	return true;
+
+}
+
+ScaleRegistry scaleRegistry;
+
+void ScaleRegistry::load() {
+	if (!started.exchange(true)) {
+		std::thread(&ScaleRegistry::run, this).detach();
+	}
+}
+
+int ScaleRegistry::find(const std::string &name) {
+
+	load();
+
+	if (!isLoaded()) {
+		return -1;
+	}
+
+	for (int i = 0; i < size(); i++) {
+		if (scales[i].name == name) {
+			return i;
+		}
+	}
+	return -1;
+
+}
+
+void ScaleRegistry::run() {
+
+	std::string dir = asset::user("AmalgamatedHarmonics/scales");
+
+	if (system::isDirectory(dir)) {
+
+		std::list<std::string> l = system::getEntries(dir);
+		std::vector<std::string> entries(l.begin(), l.end());
+		std::sort(entries.begin(), entries.end());
+
+		for (size_t i = 0; i < entries.size(); i++) {
+
+			int n = count.load(std::memory_order_relaxed);
+			if (n == MAX_SCALES) {
+				WARN("Too many scales in %s, only the first %d loaded", dir.c_str(), MAX_SCALES);
+				break;
+			}
+
+			std::string &path = entries[i];
+			std::string extension = string::filenameExtension(string::filename(path));
+			std::string name = string::filenameBase(string::filename(path));
+			std::vector<float> pitches;
+			float period = 1.0f;
+
+			bool parsed;
+			if (extension == "scl") {
+				parsed = parseScala(path, name, pitches, period);
+			} else if (extension == "json") {
+				parsed = parseJsonScale(path, name, pitches, period);
+			} else {
+				continue;
+			}
+
+			if (parsed && scales[n].compile(name, pitches, period)) {
+				count.store(n + 1, std::memory_order_release);
+			} else {
+				WARN("Could not load scale %s", path.c_str());
+			}
+
+		}
+
+	}
+
+	loaded.store(true, std::memory_order_release);
+
+}
+
 } // music
 
+namespace gui {
+
+Menu *UserScaleMenu::createChildMenu() {
+
+	struct UserScaleItem : MenuItem {
+		int *userScale;
+		int scale;
+		void onAction(const rack::event::Action &e) override {
+			*userScale = scale;
+		}
+	};
+
+	Menu *menu = new Menu;
+
+	UserScaleItem *noneItem = createMenuItem<UserScaleItem>(noneName, CHECKMARK(*userScale < 0));
+	noneItem->userScale = userScale;
+	noneItem->scale = -1;
+	menu->addChild(noneItem);
+
+	for (int i = 0; i < music::scaleRegistry.size(); i++) {
+		UserScaleItem *item = createMenuItem<UserScaleItem>(music::scaleRegistry.get(i).name, CHECKMARK(*userScale == i));
+		item->userScale = userScale;
+		item->scale = i;
+		menu->addChild(item);
+	}
+
+	return menu;
+
+}
+
+} // gui
+
 } // ah
\ No newline at end of file
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <iostream>
 
 #include "AH.hpp"
@@ -43,6 +45,11 @@ struct AHModule : rack::Module {
 		}
 	}
 
+	// Worst-case time spent in a single call to process(), in ns. Only measured by modules that 
+	// create a ProcessTimer and only while timeProcess is set, see gui::ProcessTimeItem
+	bool timeProcess = false;
+	std::atomic<int64_t> maxProcessTime {0};
+
 	bool receiveEvents = false;
 	int keepStateDisplay = 0;
 	std::string paramState = ">";
@@ -68,40 +75,172 @@ struct AHModule : rack::Module {
 
 };
 
+/*
+* Lock-free single-producer, single-consumer triple buffer. The producer fills getBack() and publish()es it, 
+* the consumer read()s the most recently published value; neither side blocks nor sees a partially written T
+*/
+template <typename T>
+struct TripleBuffer {
+
+	T slots[3];
+
+	T &getBack() {
+		return slots[back];
+	}
+
+	void publish() {
+		back = middle.exchange(back | FRESH) & ~FRESH;
+	}
+
+	// True if a value has been published since the last read()
+	bool isFresh() {
+		return middle.load() & FRESH;
+	}
+
+	const T &read() {
+		if (middle.load() & FRESH) {
+			front = middle.exchange(front) & ~FRESH;
+		}
+		return slots[front];
+	}
+
+private:
+	static constexpr int FRESH = 4;
+
+	int back = 0;
+	int front = 1;
+	std::atomic<int> middle {2};
+
+};
+
+// Scoped timer, create at the top of process() to update AHModule::maxProcessTime
+struct ProcessTimer {
+
+	AHModule *module;
+	std::chrono::steady_clock::time_point start;
+
+	ProcessTimer(AHModule *module) : module(module) {
+		if (module->timeProcess) {
+			start = std::chrono::steady_clock::now();
+		}
+	}
+
+	~ProcessTimer() {
+		if (module->timeProcess) {
+			int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+			if (ns > module->maxProcessTime.load(std::memory_order_relaxed)) {
+				module->maxProcessTime.store(ns, std::memory_order_relaxed);
+			}
+		}
+	}
+
+};
+
 } // namespace core
 
 namespace gui {
 
+// Plugin fonts and component graphics, loaded on first use and then shared by every widget
+enum FontId {
+	FONT_EUROSTILE,
+	FONT_DSEG14,
+	NUM_FONTS
+};
+
+enum SvgId {
+	SVG_BUTTON,
+	SVG_KNOB,
+	SVG_BIGKNOB,
+	SVG_TRIMPOT,
+	NUM_SVGS
+};
+
+std::shared_ptr<Font> getFont(FontId id);
+std::shared_ptr<Svg> getSvg(SvgId id);
+
+/*
+* A display drawn from a copy of the module state it shows. Kept in a DisplayCache, it is only redrawn when 
+* snapshot() finds that the state has changed.
+*/
+struct SnapshotDisplay : TransparentWidget {
+	// Copy the state to be drawn, returns true if it differs from the last copy
+	virtual bool snapshot() = 0;
+};
+
+// Composites a cached texture of the display, which is redrawn into it only when needed
+struct DisplayCache : FramebufferWidget {
+
+	SnapshotDisplay *display;
+	math::Rect drawnBox;
+
+	DisplayCache(SnapshotDisplay *display) : display(display) {
+		addChild(display);
+	}
+
+	void draw(const DrawArgs &args) override {
+		// Covers the display from the parent's origin, so the display keeps its position
+		box.size = display->box.getBottomRight();
+		if (display->snapshot() || !display->box.isEqual(drawnBox)) {
+			drawnBox = display->box;
+			dirty = true;
+		}
+		FramebufferWidget::draw(args);
+	}
+
+};
+
 struct AHChoice : LedDisplayChoice {
 	AHChoice();
 
 	float fontSize;
 
-	void draw(NVGcontext *vg) override;
+	// Subclasses update text and color in step(), the label redraws when they change
+	struct Label : SnapshotDisplay {
+		AHChoice *choice;
+		std::string text;
+		NVGcolor color;
+
+		bool snapshot() override;
+		void draw(const DrawArgs &args) override;
+	};
+
+	Label *label;
+	DisplayCache *cache;
+
+	void draw(const DrawArgs &args) override;
 };
 
-struct StateDisplay : TransparentWidget {
+struct StateDisplay : SnapshotDisplay {
 
 	core::AHModule *module;
 	std::shared_ptr<Font> font;
+	std::string state;
 
 	StateDisplay() {
-		font = APP->window->loadFont(asset::plugin(pluginInstance, "res/EurostileBold.ttf"));
+		font = getFont(FONT_EUROSTILE);
+	}
+
+	bool snapshot() override {
+		if (module->paramState == state) {
+			return false;
+		}
+		state = module->paramState;
+		return true;
 	}
 
-	void draw(NVGcontext *vg) override {
+	void draw(const DrawArgs &ctx) override {
 
 		Vec pos = Vec(0, 15);
 
-		nvgFontSize(vg, 16);
-		nvgFontFaceId(vg, font->handle);
-		nvgTextLetterSpacing(vg, -1);
+		nvgFontSize(ctx.vg, 16);
+		nvgFontFaceId(ctx.vg, font->handle);
+		nvgTextLetterSpacing(ctx.vg, -1);
 
-		nvgFillColor(vg, nvgRGBA(0x00, 0xFF, 0xFF, 0xFF));
+		nvgFillColor(ctx.vg, nvgRGBA(0x00, 0xFF, 0xFF, 0xFF));
 
 		char text[128];
-		snprintf(text, sizeof(text), "%s", module->paramState.c_str());
-		nvgText(vg, pos.x + 10, pos.y + 5, text, NULL);			
+		snprintf(text, sizeof(text), "%s", state.c_str());
+		nvgText(ctx.vg, pos.x + 10, pos.y + 5, text, NULL);			
 
 	}
 
@@ -129,7 +268,7 @@ struct AHParamWidget { // it's a mix-in
 struct AHButton : SVGSwitch {
 	AHButton() {
 		momentary = true;
-		addFrame(APP->window->loadSvg(asset::plugin(pluginInstance,"res/ComponentLibrary/AHButton.svg")));
+		addFrame(getSvg(SVG_BUTTON));
 	}	
 };
 
@@ -147,42 +286,57 @@ struct AHKnob : RoundKnob, AHParamWidget {
 struct AHKnobSnap : AHKnob {
 	AHKnobSnap() {
 		snap = true;
-		setSvg(APP->window->loadSvg(asset::plugin(pluginInstance,"res/ComponentLibrary/AHKnob.svg")));
+		setSvg(getSvg(SVG_KNOB));
 	}
 };
 
 struct AHKnobNoSnap : AHKnob {
 	AHKnobNoSnap() {
 		snap = false;
-		setSvg(APP->window->loadSvg(asset::plugin(pluginInstance,"res/ComponentLibrary/AHKnob.svg")));
+		setSvg(getSvg(SVG_KNOB));
 	}
 };
 
 struct AHBigKnobNoSnap : AHKnob {
 	AHBigKnobNoSnap() {
 		snap = false;
-		setSvg(APP->window->loadSvg(asset::plugin(pluginInstance,"res/ComponentLibrary/AHBigKnob.svg")));
+		setSvg(getSvg(SVG_BIGKNOB));
 	}
 };
 
 struct AHBigKnobSnap : AHKnob {
 	AHBigKnobSnap() {
 		snap = true;
-		setSvg(APP->window->loadSvg(asset::plugin(pluginInstance,"res/ComponentLibrary/AHBigKnob.svg")));
+		setSvg(getSvg(SVG_BIGKNOB));
 	}
 };
 
 struct AHTrimpotSnap : AHKnob {
 	AHTrimpotSnap() {
 		snap = true;
-		setSvg(APP->window->loadSvg(asset::plugin(pluginInstance,"res/ComponentLibrary/AHTrimpot.svg")));
+		setSvg(getSvg(SVG_TRIMPOT));
 	}
 };
 
 struct AHTrimpotNoSnap : AHKnob {
 	AHTrimpotNoSnap() {
 		snap = false;
-		setSvg(APP->window->loadSvg(asset::plugin(pluginInstance,"res/ComponentLibrary/AHTrimpot.svg")));
+		setSvg(getSvg(SVG_TRIMPOT));
+	}
+};
+
+// Toggles process() timing on the module and shows the worst case seen since it was switched on
+struct ProcessTimeItem : MenuItem {
+	core::AHModule *module;
+
+	void onAction(const rack::event::Action &e) override {
+		module->maxProcessTime = 0;
+		module->timeProcess ^= true;
+	}
+
+	void step() override {
+		rightText = module->timeProcess ? string::f("%.2f µs", module->maxProcessTime / 1000.0) : "Off";
+		MenuItem::step();
 	}
 };
 
@@ -240,7 +394,205 @@ namespace digital {
 
 static constexpr float TRIGGER = 1e-3f;
 
-double gaussrand();
+/*
+* Per-module random number generator (xoroshiro128+), so that modules do not contend on the global state of rand()
+* and each module owns a stream that can be seeded on its own. Not thread-safe, use from one thread only.
+*/
+struct Random {
+
+	uint64_t state[2];
+
+	// A fixed seed makes the stream repeatable, the state is then saved with the patch so that a reload resumes the sequence
+	bool fixed = false;
+	uint64_t fixedSeed = 0;
+
+	Random() {
+		seed(random::u64());
+	}
+
+	explicit Random(uint64_t s) {
+		seed(s);
+	}
+
+	// Expand the seed with splitmix64, which guarantees a non-zero state
+	void seed(uint64_t s) {
+		for (int i = 0; i < 2; i++) {
+			s += 0x9e3779b97f4a7c15ULL;
+			uint64_t z = s;
+			z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+			z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+			state[i] = z ^ (z >> 31);
+		}
+	}
+
+	void setFixedSeed(uint64_t s) {
+		fixed = true;
+		fixedSeed = s;
+		seed(s);
+	}
+
+	void setFreeRunning() {
+		fixed = false;
+		seed(random::u64());
+	}
+
+	// Back to the start of the sequence of a fixed seed
+	void restart() {
+		if (fixed) {
+			seed(fixedSeed);
+		}
+	}
+
+	json_t *toJson();
+	void fromJson(json_t *rootJ);
+
+	uint64_t u64() {
+		uint64_t s0 = state[0];
+		uint64_t s1 = state[1];
+		uint64_t result = s0 + s1;
+		s1 ^= s0;
+		state[0] = ((s0 << 55) | (s0 >> 9)) ^ s1 ^ (s1 << 14);
+		state[1] = (s1 << 36) | (s1 >> 28);
+		return result;
+	}
+
+	uint32_t u32() {
+		return u64() >> 32;
+	}
+
+	// [0, 1)
+	float uniform() {
+		return (u32() >> 8) * (1.0f / 16777216.0f);
+	}
+
+	// [0, n)
+	int range(int n) {
+		return (int)(((uint64_t)u32() * (uint64_t)n) >> 32);
+	}
+
+};
+
+/*
+* A change of seed posted from the UI thread and applied by process(), so that only the engine thread touches the stream.
+* A newer request replaces one that has not been applied yet.
+*/
+struct SeedRequest {
+
+	enum Op {
+		NONE,
+		FREE_RUNNING,
+		FIXED_SEED,
+		RESTART
+	};
+
+	std::atomic<int> op {NONE};
+	std::atomic<uint64_t> seed {0}; // Only read for FIXED_SEED
+
+	void post(Op o, uint64_t s = 0) {
+		if (o == FIXED_SEED) {
+			seed = s;
+		}
+		op = o;
+	}
+
+	// Returns true if the stream was changed
+	bool apply(Random &rng) {
+		switch (op.exchange(NONE)) {
+			case FREE_RUNNING:	rng.setFreeRunning(); return true;
+			case FIXED_SEED:	rng.setFixedSeed(seed); return true;
+			case RESTART:		rng.restart(); return rng.fixed;
+			default:			return false;
+		}
+	}
+
+};
+
+/*
+* Standard normal draws clamped to [-2, 2], as used for the timing spread of Imp, Imperfect2 and Generative.
+* Looks up a table of the inverse CDF with one uniform draw, rather than Box-Muller's log, sqrt, sin and cos
+*/
+float clampedNormal(Random &rng);
+void clampedNormals(Random &rng, float *out, int n);
+
+/*
+* Walker's alias method: built in O(N) from a set of (unnormalised) weights, then sampled in O(1) from a single uniform draw.
+* Fixed capacity, so that it can be rebuilt on the audio thread without allocating.
+*/
+template <int MAX>
+struct AliasTable {
+
+	float prob[MAX];
+	int alias[MAX];
+	int size = 0;
+
+	void build(const float *weights, int n) {
+
+		size = n;
+
+		float total = 0.0f;
+		for (int i = 0; i < n; i++) {
+			total += weights[i];
+		}
+
+		// Nothing to choose between, so make it uniform
+		if (total <= 0.0f) {
+			for (int i = 0; i < n; i++) {
+				prob[i] = 1.0f;
+				alias[i] = i;
+			}
+			return;
+		}
+
+		float scaled[MAX];
+		int small[MAX];
+		int large[MAX];
+		int nSmall = 0;
+		int nLarge = 0;
+
+		for (int i = 0; i < n; i++) {
+			scaled[i] = weights[i] * n / total;
+			if (scaled[i] < 1.0f) {
+				small[nSmall++] = i;
+			} else {
+				large[nLarge++] = i;
+			}
+		}
+
+		while (nSmall && nLarge) {
+			int s = small[--nSmall];
+			int l = large[--nLarge];
+			prob[s] = scaled[s];
+			alias[s] = l;
+			scaled[l] = (scaled[l] + scaled[s]) - 1.0f;
+			if (scaled[l] < 1.0f) {
+				small[nSmall++] = l;
+			} else {
+				large[nLarge++] = l;
+			}
+		}
+
+		// Anything left over is 1 within rounding error
+		while (nLarge) {
+			int l = large[--nLarge];
+			prob[l] = 1.0f;
+			alias[l] = l;
+		}
+		while (nSmall) {
+			int s = small[--nSmall];
+			prob[s] = 1.0f;
+			alias[s] = s;
+		}
+
+	}
+
+	// u in [0, 1)
+	int sample(float u) const {
+		float x = u * size;
+		int i = std::min((int)x, size - 1);
+		return (x - i < prob[i]) ? i : alias[i];
+	}
+
+};
 
 struct AHPulseGenerator {
 	float time = 0.f;
@@ -267,6 +619,360 @@ struct AHPulseGenerator {
 	}
 };
 
+/*
+* N Schmitt triggers held as struct-of-arrays and processed 4 lanes at a time. Same thresholds as
+* rack::dsp::SchmittTrigger, and like it starts high so that an input that is already high does not fire.
+* N must be a multiple of 4 and at most 32, lanes are returned as a bitmask.
+*/
+template <int N>
+struct TriggerBank {
+
+	static_assert(N % 4 == 0 && N <= 32, "TriggerBank size must be a multiple of 4 up to 32");
+
+	simd::float_4 state[N / 4];
+
+	TriggerBank() {
+		reset();
+	}
+
+	void reset() {
+		for (int k = 0; k < N / 4; k++) {
+			state[k] = simd::float_4::mask();
+		}
+	}
+
+	// Lanes of in[0..N) that crossed 1V from low
+	uint32_t process(const float *in) {
+		uint32_t rose = 0;
+		for (int k = 0; k < N / 4; k++) {
+			simd::float_4 v = simd::float_4::load(in + k * 4);
+			simd::float_4 on = (v >= 1.0f);
+			simd::float_4 off = (v <= 0.0f);
+			simd::float_4 triggered = ~state[k] & on;
+			state[k] = on | (state[k] & ~off);
+			rose |= (uint32_t)simd::movemask(triggered) << (k * 4);
+		}
+		return rose;
+	}
+
+};
+
+/*
+* N AHPulseGenerators held as struct-of-arrays and processed 4 lanes at a time, with the same semantics:
+* a trigger only replaces a pulse that would end sooner, and a pulse is high while it has time remaining after the step.
+* processLong() follows dsp::PulseGenerator instead, high while time remained before the step, one sample longer.
+* N must be a multiple of 4 and at most 32, lanes are returned as a bitmask.
+*/
+template <int N>
+struct PulseBank {
+
+	static_assert(N % 4 == 0 && N <= 32, "PulseBank size must be a multiple of 4 up to 32");
+
+	float remaining[N] = {};
+	simd::float_4 high[N / 4];
+
+	PulseBank() {
+		for (int k = 0; k < N / 4; k++) {
+			high[k] = simd::float_4::zero();
+		}
+	}
+
+	bool isHigh(int lane) {
+		return remaining[lane] > 0.0f;
+	}
+
+	bool trigger(int lane, float pulseTime) {
+		if (pulseTime >= remaining[lane]) {
+			remaining[lane] = pulseTime;
+			return true;
+		} else {
+			return false;
+		}
+	}
+
+	void trigger(uint32_t lanes, float pulseTime) {
+		for (int i = 0; i < N; i++) {
+			if ((lanes >> i) & 1) {
+				trigger(i, pulseTime);
+			}
+		}
+	}
+
+	// Lanes still high after the step
+	uint32_t process(float deltaTime) {
+		uint32_t mask = 0;
+		for (int k = 0; k < N / 4; k++) {
+			simd::float_4 r = simd::float_4::load(remaining + k * 4) - deltaTime;
+			high[k] = (r > 0.0f);
+			simd::fmax(r, 0.0f).store(remaining + k * 4);
+			mask |= (uint32_t)simd::movemask(high[k]) << (k * 4);
+		}
+		return mask;
+	}
+
+	// Lanes that were high before the step
+	uint32_t processLong(float deltaTime) {
+		uint32_t mask = 0;
+		for (int k = 0; k < N / 4; k++) {
+			simd::float_4 r = simd::float_4::load(remaining + k * 4);
+			high[k] = (r > 0.0f);
+			simd::fmax(r - deltaTime, 0.0f).store(remaining + k * 4);
+			mask |= (uint32_t)simd::movemask(high[k]) << (k * 4);
+		}
+		return mask;
+	}
+
+	// Write voltage to the lanes that were high at the last step and 0V to the rest
+	void store(float *out, float voltage) {
+		for (int k = 0; k < N / 4; k++) {
+			simd::ifelse(high[k], voltage, 0.0f).store(out + k * 4);
+		}
+	}
+
+};
+
+/*
+* Windowed min, max, mean and RMS of N channels, and the peak absolute value since reset(). Samples are folded
+* 4 lanes at a time into blocks and the window is the last BLOCKS blocks: min and max come from per-channel
+* monotonic deques of block extremes and mean and RMS from running sums, so each sample costs O(1).
+* Results are refreshed at the end of every block.
+*/
+template <int N>
+struct WindowStats {
+
+	static_assert(N % 4 == 0, "WindowStats size must be a multiple of 4");
+
+	static const int BLOCKS = 64;
+
+	// Block extremes in the order they were completed, the front is the extreme of the window
+	struct Deque {
+		int64_t block[BLOCKS];
+		float value[BLOCKS];
+		int head = 0;
+		int size = 0;
+
+		int back() const {
+			return (head + size - 1) % BLOCKS;
+		}
+
+		void push(int64_t b, float v) {
+			int i = (head + size) % BLOCKS;
+			block[i] = b;
+			value[i] = v;
+			size++;
+		}
+
+		void popFront() {
+			head = (head + 1) % BLOCKS;
+			size--;
+		}
+	};
+
+	int blockLength = 1;
+	int blockPos = 0;
+	int64_t blockCount = 0;
+	int filled = 0;
+
+	simd::float_4 blockMin[N / 4];
+	simd::float_4 blockMax[N / 4];
+	simd::float_4 blockSum[N / 4];
+	simd::float_4 blockSquares[N / 4];
+	simd::float_4 peakAbs[N / 4];
+
+	float sums[BLOCKS][N];
+	float squares[BLOCKS][N];
+	float totalSum[N];
+	float totalSquares[N];
+	Deque minQ[N];
+	Deque maxQ[N];
+
+	float min[N];
+	float max[N];
+	float mean[N];
+	float rms[N];
+	float peak[N];
+
+	WindowStats() {
+		reset();
+	}
+
+	void setWindow(float seconds, float sampleRate) {
+		blockLength = std::max(1, (int)std::round(seconds * sampleRate / BLOCKS));
+		reset();
+	}
+
+	void reset() {
+		blockPos = 0;
+		blockCount = 0;
+		filled = 0;
+		for (int k = 0; k < N / 4; k++) {
+			startBlock(k);
+			peakAbs[k] = simd::float_4::zero();
+		}
+		for (int c = 0; c < N; c++) {
+			totalSum[c] = 0.0f;
+			totalSquares[c] = 0.0f;
+			minQ[c].head = minQ[c].size = 0;
+			maxQ[c].head = maxQ[c].size = 0;
+			min[c] = max[c] = mean[c] = rms[c] = peak[c] = 0.0f;
+		}
+		for (int b = 0; b < BLOCKS; b++) {
+			std::fill(sums[b], sums[b] + N, 0.0f);
+			std::fill(squares[b], squares[b] + N, 0.0f);
+		}
+	}
+
+	void resetPeak() {
+		for (int k = 0; k < N / 4; k++) {
+			peakAbs[k] = simd::float_4::zero();
+		}
+	}
+
+	void process(const float *in) {
+		for (int k = 0; k < N / 4; k++) {
+			simd::float_4 v = simd::float_4::load(in + k * 4);
+			blockMin[k] = simd::fmin(blockMin[k], v);
+			blockMax[k] = simd::fmax(blockMax[k], v);
+			blockSum[k] += v;
+			blockSquares[k] += v * v;
+			peakAbs[k] = simd::fmax(peakAbs[k], simd::fabs(v));
+		}
+		if (++blockPos >= blockLength) {
+			endBlock();
+		}
+	}
+
+private:
+	void startBlock(int k) {
+		blockMin[k] = INFINITY;
+		blockMax[k] = -INFINITY;
+		blockSum[k] = simd::float_4::zero();
+		blockSquares[k] = simd::float_4::zero();
+	}
+
+	void endBlock() {
+
+		float bMin[N], bMax[N];
+		int slot = blockCount % BLOCKS;
+		for (int k = 0; k < N / 4; k++) {
+			blockMin[k].store(bMin + k * 4);
+			blockMax[k].store(bMax + k * 4);
+			peakAbs[k].store(peak + k * 4);
+
+			// Slide the sums: take off the block leaving the window, add the new one
+			simd::float_4 total = simd::float_4::load(totalSum + k * 4) + blockSum[k];
+			simd::float_4 totalSq = simd::float_4::load(totalSquares + k * 4) + blockSquares[k];
+			if (filled == BLOCKS) {
+				total -= simd::float_4::load(sums[slot] + k * 4);
+				totalSq -= simd::float_4::load(squares[slot] + k * 4);
+			}
+			total.store(totalSum + k * 4);
+			totalSq.store(totalSquares + k * 4);
+			blockSum[k].store(sums[slot] + k * 4);
+			blockSquares[k].store(squares[slot] + k * 4);
+
+			startBlock(k);
+		}
+		filled = std::min(filled + 1, (int)BLOCKS);
+
+		// Resum once per lap so that rounding errors in the running totals do not accumulate
+		if (slot == BLOCKS - 1) {
+			for (int c = 0; c < N; c++) {
+				totalSum[c] = 0.0f;
+				totalSquares[c] = 0.0f;
+				for (int b = 0; b < BLOCKS; b++) {
+					totalSum[c] += sums[b][c];
+					totalSquares[c] += squares[b][c];
+				}
+			}
+		}
+
+		float samples = (float)filled * blockLength;
+		int64_t oldest = blockCount - BLOCKS + 1;
+		for (int c = 0; c < N; c++) {
+			Deque &lo = minQ[c];
+			while (lo.size > 0 && lo.block[lo.head] < oldest) {
+				lo.popFront();
+			}
+			while (lo.size > 0 && lo.value[lo.back()] >= bMin[c]) {
+				lo.size--;
+			}
+			lo.push(blockCount, bMin[c]);
+
+			Deque &hi = maxQ[c];
+			while (hi.size > 0 && hi.block[hi.head] < oldest) {
+				hi.popFront();
+			}
+			while (hi.size > 0 && hi.value[hi.back()] <= bMax[c]) {
+				hi.size--;
+			}
+			hi.push(blockCount, bMax[c]);
+
+			min[c] = lo.value[lo.head];
+			max[c] = hi.value[hi.head];
+			mean[c] = totalSum[c] / samples;
+			rms[c] = std::sqrt(std::max(totalSquares[c] / samples, 0.0f));
+		}
+
+		blockPos = 0;
+		blockCount++;
+
+	}
+
+};
+
+/*
+* Schedule for a fixed set of timers counted in samples. The earliest due time is cached, so that between events
+* checking the schedule is a single comparison however many timers there are
+*/
+template <int N>
+struct TimerSchedule {
+
+	const static int64_t NEVER = INT64_MAX;
+
+	int64_t now = 0;
+	int64_t due[N];
+	int64_t next = NEVER;
+
+	TimerSchedule() {
+		reset();
+	}
+
+	void reset() {
+		now = 0;
+		std::fill(due, due + N, (int64_t)NEVER);
+		next = NEVER;
+	}
+
+	// Fire timer i after the given number of samples, 0 is the current sample
+	void schedule(int i, int64_t samples) {
+		due[i] = now + samples;
+		next = std::min(next, due[i]);
+	}
+
+	void cancel(int i) {
+		due[i] = NEVER;
+	}
+
+	bool pending() const {
+		return now >= next;
+	}
+
+	bool isDue(int i) const {
+		return due[i] <= now;
+	}
+
+	// Call once the due timers have been handled
+	void update() {
+		next = *std::min_element(due, due + N);
+	}
+
+	void tick() {
+		now++;
+	}
+
+};
+
 struct BpmCalculator {
 
 	float timer = 0.0f;
@@ -328,6 +1034,17 @@ struct BpmCalculator {
 
 } // namespace digital
 
+namespace gui {
+
+// Context menu to choose between a free-running and a fixed seed for a module's random stream
+struct SeedMenu : MenuItem {
+	digital::Random *rng;
+	digital::SeedRequest *request;
+	Menu *createChildMenu() override;
+};
+
+} // namespace gui
+
 namespace music {
 
 const static int NUM_CHORDS = 99; // FIXME Remove this
@@ -353,8 +1070,11 @@ struct Chord {
 		inversion = 0;
 		octave = 0;
 	}
-	void setVoltages(int *chordArray, int offset);
-	void setVoltages(std::vector<int> &chordArray, int offset);
+	void setVoltages(int *chordArray, int offset, digital::Random &rng);
+	void setVoltages(std::vector<int> &chordArray, int offset, digital::Random &rng);
+
+	json_t *toJson();
+	bool fromJson(json_t *rootJ);
 
 };
 
@@ -443,6 +1163,66 @@ enum Quality {
 	NUM_QUALITY
 };
 
+/*
+* A set of pitch classes as a 12-bit mask, bit n is set when the note n semi-tones above the root is a member.
+* Transposition is a rotation of the mask and the modes of a scale are rotations that bring one of its members to 0.
+*/
+struct PitchClassSet {
+
+	uint16_t bits;
+
+	PitchClassSet() : bits(0) {}
+	explicit PitchClassSet(int b) : bits(b & 0xFFF) {}
+
+	static PitchClassSet fromNotes(const int *notes, int n);
+
+	bool contains(int pc) const {
+		return (bits >> rack::math::eucMod(pc, 12)) & 1;
+	}
+
+	int size() const {
+		return __builtin_popcount(bits);
+	}
+
+	PitchClassSet transpose(int semitones) const {
+		int n = rack::math::eucMod(semitones, 12);
+		return PitchClassSet((bits << n) | (bits >> (12 - n)));
+	}
+
+	/*
+	* The i-th member counting up from the lowest, continuing into the next (or previous) octaves,
+	* so nth(size()) == nth(0) + 12. Returns 0 for the empty set.
+	*/
+	int nth(int i) const;
+
+	// The mode starting on the i-th member
+	PitchClassSet mode(int i) const {
+		return transpose(-nth(i));
+	}
+
+	// The triad built in thirds on the i-th member, relative to that member
+	PitchClassSet triad(int i) const;
+
+	bool operator==(const PitchClassSet &other) const {
+		return bits == other.bits;
+	}
+
+	bool operator!=(const PitchClassSet &other) const {
+		return bits != other.bits;
+	}
+
+};
+
+/*
+* Quality of a triad relative to its root: major if it has a major third, diminished if it has a minor third and
+* diminished fifth, otherwise minor.
+*/
+int getTriadQuality(PitchClassSet triad);
+
+extern PitchClassSet ScaleSets[NUM_SCALES];
+
+extern PitchClassSet ModeSets[NUM_MODES];
+
 /*
 * Convert a V/OCT voltage to a quantized pitch, key and scale, and calculate various information about the quantised note.
 */
@@ -470,30 +1250,16 @@ int getKeyFromVolts(float volts);
 
 void getRootFromMode(int inMode, int inRoot, int inTonic, int *currRoot, int *quality);
 
-extern int ModeQuality[7][7];
+/*
+* Convert a 6-note chord formula (semi-tones relative to the root, negative notes are repeats) to 6 V/OCT voltages.
+* rng is only used to randomise the octave of the repeats when offset is 0, otherwise it may be NULL
+*/
+void getVoltsFromChord(const int *chordArray, int rootNote, int octave, int offset, float *outVolts, digital::Random *rng);
 
 extern int ModeOffset[7][7];
 
 extern std::string DegreeString[7][7];
 
-// NOTE_C = 0,
-// NOTE_D_FLAT, // C Sharp
-// NOTE_D,
-// NOTE_E_FLAT, // D Sharp
-// NOTE_E,
-// NOTE_F,
-// NOTE_G_FLAT, //F Sharp
-// NOTE_G,
-// NOTE_A_FLAT, // G Sharp
-// NOTE_A,
-// NOTE_B_FLAT, // A Sharp
-// NOTE_B,
-
-//0	1	2	3	4	5	6	7	8	9	10	11	12
-extern int tonicIndex[13];
-extern int scaleIndex[7];
-extern int noteIndex[13];
-			
 // Reference, midi note to scale
 // 0	1
 // 1	b2 (#1)
@@ -566,8 +1332,130 @@ struct KnownChords {
 	void dump();
 };
 
+/*
+* Direct-address index from the pitch classes of a chord, transposed so that its bass note is 0, to the
+* BasicChordSet chord it spells. Every inversion of every chord is indexed; where two chords share a set the
+* earlier one in BasicChordSet wins. Bit 0 of the key is always set, so it is dropped and 2048 entries suffice.
+*/
+struct ChordIndex {
+
+	struct Entry {
+		int16_t chord = -1; // Index into BasicChordSet, -1 if the set is not a known chord
+		int8_t root = 0; // Pitch class of the root relative to the bass
+		int8_t inversion = 0;
+	};
+
+	Entry entries[2048];
+
+	ChordIndex();
+
+	// notes must contain bass
+	const Entry &find(PitchClassSet notes, int bass) const {
+		return entries[notes.transpose(-bass).bits >> 1];
+	}
+
+};
+
+extern ChordIndex chordIndex;
+
 extern InversionDefinition defaultChord;
 
+/*
+* Weighted transition matrix between the degrees of a mode, weights[from][to]. Row NUM_DEGREES is used
+* when the previous chord was not taken from the mode. Can be loaded from a JSON file of the form
+* {"degrees": [[w, w, w, w, w, w, w], ...]} with 7 or 8 rows.
+*/
+struct DegreeTransitions {
+
+	float weights[NUM_DEGREES + 1][NUM_DEGREES];
+
+	json_t *toJson();
+	bool fromJson(json_t *rootJ);
+	bool load(const char *path);
+
+};
+
+// Key and mode selected on a module, published by the audio thread for the widget to derive names from.
+// Kept to 4 bytes so that std::atomic<KeyModeState> is lock-free
+struct KeyModeState {
+	int8_t selection; // Module specific chord selection mode
+	int8_t key;
+	int8_t mode;
+	int8_t spare;
+};
+
+/*
+* A user scale compiled for quantising. Holds the pitches of one period above the root in V, extended by one pitch
+* either side, and the boundaries half-way between them padded with +inf, so that quantising is a binary search
+* of fixed length whatever the size of the scale
+*/
+struct CompiledScale {
+
+	const static int MAX_PITCHES = 128; // Power of 2, allows up to MAX_PITCHES - 2 pitches per period
+
+	std::string name;
+	float period = 1.0f; // V, 1.0 is an octave
+	int size = 0;
+	float pitches[MAX_PITCHES];
+	float bounds[MAX_PITCHES];
+
+	// pitches are in V above the root, in any order
+	bool compile(const std::string &scaleName, std::vector<float> pitchList, float scalePeriod);
+	float quantise(float inVolts, int root) const;
+
+};
+
+/*
+* Scales loaded from JSON pitch lists and Scala (.scl) files in the user folder, AmalgamatedHarmonics/scales.
+* Files are read and compiled on a background thread. Each scale is published by bumping the count once it is
+* complete and is never changed after, so the audio thread can use any scale below size() without locking
+*/
+struct ScaleRegistry {
+
+	const static int MAX_SCALES = 64;
+
+	// Start loading if not already started
+	void load();
+
+	// Index of the named scale, -1 if not found or the scales are still loading
+	int find(const std::string &name);
+
+	bool isLoaded() {
+		return loaded.load(std::memory_order_acquire);
+	}
+
+	int size() {
+		return count.load(std::memory_order_acquire);
+	}
+
+	const CompiledScale &get(int i) {
+		return scales[i];
+	}
+
+private:
+
+	CompiledScale scales[MAX_SCALES];
+	std::atomic<int> count {0};
+	std::atomic<bool> started {false};
+	std::atomic<bool> loaded {false};
+
+	void run();
+
+};
+
+extern ScaleRegistry scaleRegistry;
+
 } // namespace music
 
+namespace gui {
+
+// Choice of a loaded user scale, or -1 to use the module's own scales
+struct UserScaleMenu : MenuItem {
+	int *userScale;
+	std::string noneName;
+	Menu *createChildMenu() override;
+};
+
+} // namespace gui
+
 } // namespace ah
\ No newline at end of file
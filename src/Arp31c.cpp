@@ -249,7 +249,7 @@ struct Arp31 : core::AHModule {
 		configParam(ARP_PARAM, 0.0, 3.0, 0.0, "Arpeggio type"); 
 
 		onReset();
-		id = rand();
+		id = random::u32();
         debugFlag = false;
 	}
 
@@ -497,13 +497,22 @@ void Arp31::process(const ProcessArgs &args) {
 	
 }
 
-struct Arp31Display : TransparentWidget {
+struct Arp31Display : gui::SnapshotDisplay {
 	
 	Arp31 *module;
 	std::shared_ptr<Font> font;
+	Arpeggio *arp = NULL; // Arpeggios have fixed names
 
 	Arp31Display() {
-		font = APP->window->loadFont(asset::plugin(pluginInstance, "res/EurostileBold.ttf"));
+		font = gui::getFont(gui::FONT_EUROSTILE);
+	}
+
+	bool snapshot() override {
+		if (module == NULL || module->uiArp == arp) {
+			return false;
+		}
+		arp = module->uiArp;
+		return true;
 	}
 
 	void draw(const DrawArgs &ctx) override {
@@ -521,7 +530,7 @@ struct Arp31Display : TransparentWidget {
 		nvgFillColor(ctx.vg, nvgRGBA(0x00, 0xFF, 0xFF, 0xFF));
 	
 		char text[128];
-		snprintf(text, sizeof(text), "%s", module->uiArp->getName().c_str());
+		snprintf(text, sizeof(text), "%s", arp->getName().c_str());
 		nvgText(ctx.vg, pos.x + 10, pos.y + 65, text, NULL);
 		
 	}
@@ -550,9 +559,9 @@ struct Arp31Widget : ModuleWidget {
 
 		if (module != NULL) {
 			Arp31Display *displayW = createWidget<Arp31Display>(Vec(40, 100));
-			displayW->box.size = Vec(100, 70);
+			displayW->box.size = Vec(100, 90);
 			displayW->module = module;
-			addChild(displayW);
+			addChild(new gui::DisplayCache(displayW));
 		}
 		
 	}
@@ -298,7 +298,7 @@ struct Arp32 : core::AHModule {
 		paramQuantities[SCALE_PARAM]->description = "Size of each step, semitones or major or minor intervals"; 
 
 		onReset();
-		id = rand();
+		id = random::u32();
 		debugFlag = false;
 	}
 
@@ -542,13 +542,47 @@ void Arp32::process(const ProcessArgs &args) {
 
 }
 
-struct Arp32Display : TransparentWidget {
+struct Arp32Display : gui::SnapshotDisplay {
 
 	Arp32 *module;
 	std::shared_ptr<Font> font;
 
+	// Patterns have fixed names, so these are enough to tell if the text changes
+	struct State {
+		int inputLen = -1;
+		Pattern *patt = NULL;
+		int length = 0;
+		int scale = 0;
+		int trans = 0;
+	};
+
+	State state;
+
 	Arp32Display() {
-		font = APP->window->loadFont(asset::plugin(pluginInstance, "res/EurostileBold.ttf"));
+		font = gui::getFont(gui::FONT_EUROSTILE);
+	}
+
+	bool snapshot() override {
+
+		if (module == NULL) {
+			return false;
+		}
+
+		State s;
+		s.inputLen = module->inputLen;
+		s.patt = module->uiPatt;
+		s.length = module->uiPatt->length;
+		s.scale = module->uiPatt->scale;
+		s.trans = module->uiPatt->trans;
+
+		if (s.inputLen == state.inputLen && s.patt == state.patt && s.length == state.length && 
+			s.scale == state.scale && s.trans == state.trans) {
+			return false;
+		}
+
+		state = s;
+		return true;
+
 	}
 
 	void draw(const DrawArgs &ctx) override {
@@ -566,23 +600,23 @@ struct Arp32Display : TransparentWidget {
 		nvgFillColor(ctx.vg, nvgRGBA(0x00, 0xFF, 0xFF, 0xFF));
 	
 		char text[128];
-		if (module->inputLen == 0) {
+		if (state.inputLen == 0) {
 			snprintf(text, sizeof(text), "Error: inputLen == 0");
 			nvgText(ctx.vg, pos.x + 10, pos.y, text, NULL);
 		} else {
-			snprintf(text, sizeof(text), "%s", module->uiPatt->getName().c_str());
+			snprintf(text, sizeof(text), "%s", state.patt->getName().c_str());
 			nvgText(ctx.vg, pos.x + 10, pos.y, text, NULL);
-			snprintf(text, sizeof(text), "L : %d", module->uiPatt->length);
+			snprintf(text, sizeof(text), "L : %d", state.length);
 			nvgText(ctx.vg, pos.x + 10, pos.y + 15, text, NULL);
-			switch(module->uiPatt->scale) {
+			switch(state.scale) {
 				case 0: 
-					snprintf(text, sizeof(text), "S : %dst", module->uiPatt->trans);
+					snprintf(text, sizeof(text), "S : %dst", state.trans);
 					break;
 				case 1: 
-					snprintf(text, sizeof(text), "S : %dM", module->uiPatt->trans);
+					snprintf(text, sizeof(text), "S : %dM", state.trans);
 					break;
 				case 2: 
-					snprintf(text, sizeof(text), "S : %dm", module->uiPatt->trans);
+					snprintf(text, sizeof(text), "S : %dm", state.trans);
 					break;
 				default: snprintf(text, sizeof(text), "Error..."); break;
 			}
@@ -619,9 +653,9 @@ struct Arp32Widget : ModuleWidget {
 
 		if (module != NULL) {
 			Arp32Display *displayW = createWidget<Arp32Display>(Vec(10, 90));
-			displayW->box.size = Vec(100, 140);
+			displayW->box.size = Vec(120, 140);
 			displayW->module = module;
-			addChild(displayW);
+			addChild(new gui::DisplayCache(displayW));
 		}
 
 	}
@@ -464,7 +464,7 @@ struct Arpeggiator2 : core::AHModule {
 		configParam(LENGTH_PARAM, 1.0, 16.0, 1.0); 
 
 		onReset();
-		id = rand();
+		id = random::u32();
 		debugFlag = false;
 
 	}
@@ -899,14 +899,50 @@ void Arpeggiator2::process(const ProcessArgs &args) {
 
 }
 
-struct Arpeggiator2Display : TransparentWidget {
+struct Arpeggiator2Display : gui::SnapshotDisplay {
 	
 	Arpeggiator2 *module;
 	int frame = 0;
 	std::shared_ptr<Font> font;
 
+	// Patterns and arpeggios have fixed names, so these are enough to tell if the text changes
+	struct State {
+		int inputLen = -1;
+		Pattern *patt = NULL;
+		int length = 0;
+		int scale = 0;
+		int trans = 0;
+		Arpeggio *arp = NULL;
+	};
+
+	State state;
+
 	Arpeggiator2Display() {
-		font = APP->window->loadFont(asset::plugin(pluginInstance, "res/EurostileBold.ttf"));
+		font = gui::getFont(gui::FONT_EUROSTILE);
+	}
+
+	bool snapshot() override {
+
+		if (module == NULL) {
+			return false;
+		}
+
+		State s;
+		s.inputLen = module->inputLen;
+		s.patt = module->uiPatt;
+		s.length = module->uiPatt->length;
+		s.scale = module->uiPatt->scale;
+		s.trans = module->uiPatt->trans;
+		s.arp = module->uiArp;
+
+		if (s.inputLen == state.inputLen && s.patt == state.patt && s.length == state.length && 
+			s.scale == state.scale && s.trans == state.trans && s.arp == state.arp) {
+			return false;
+		}
+
+		state = s;
+		return true;
+
 	}
 
 	void draw(const DrawArgs &ctx) override {
@@ -923,25 +959,25 @@ struct Arpeggiator2Display : TransparentWidget {
 		nvgFillColor(ctx.vg, nvgRGBA(0x00, 0xFF, 0xFF, 0xFF));
 
 		char text[128];
-		if (module->inputLen == 0) {
+		if (state.inputLen == 0) {
 			snprintf(text, sizeof(text), "Error: inputLen == 0");
 			nvgText(ctx.vg, pos.x + 10, pos.y + 5, text, NULL);			
 		} else {
-			snprintf(text, sizeof(text), "Pattern: %s", module->uiPatt->getName().c_str());
+			snprintf(text, sizeof(text), "Pattern: %s", state.patt->getName().c_str());
 			nvgText(ctx.vg, pos.x + 10, pos.y + 5, text, NULL);
 
-			snprintf(text, sizeof(text), "Length: %d", module->uiPatt->length);
+			snprintf(text, sizeof(text), "Length: %d", state.length);
 			nvgText(ctx.vg, pos.x + 10, pos.y + 25, text, NULL);
 
-			switch(module->uiPatt->scale) {
-				case 0: snprintf(text, sizeof(text), "Transpose: %d s.t.", module->uiPatt->trans); break;
-				case 1: snprintf(text, sizeof(text), "Transpose: %d Maj. int.", module->uiPatt->trans); break;
-				case 2: snprintf(text, sizeof(text), "Transpose: %d Min. int.", module->uiPatt->trans); break;
+			switch(state.scale) {
+				case 0: snprintf(text, sizeof(text), "Transpose: %d s.t.", state.trans); break;
+				case 1: snprintf(text, sizeof(text), "Transpose: %d Maj. int.", state.trans); break;
+				case 2: snprintf(text, sizeof(text), "Transpose: %d Min. int.", state.trans); break;
 				default: snprintf(text, sizeof(text), "Error..."); break;
 			}
 			nvgText(ctx.vg, pos.x + 10, pos.y + 45, text, NULL);
 
-			snprintf(text, sizeof(text), "Arpeggio: %s", module->uiArp->getName().c_str());
+			snprintf(text, sizeof(text), "Arpeggio: %s", state.arp->getName().c_str());
 			nvgText(ctx.vg, pos.x + 10, pos.y + 65, text, NULL);
 		}
 	}
@@ -985,8 +1021,8 @@ struct Arpeggiator2Widget : ModuleWidget {
 		if (module != NULL) {
 			Arpeggiator2Display *display = createWidget<Arpeggiator2Display>(Vec(10, 95));
 			display->module = module;
-			display->box.size = Vec(100, 140);
-			addChild(display);
+			display->box.size = Vec(220, 140);
+			addChild(new gui::DisplayCache(display));
 		}
 
 	}
@@ -2,6 +2,7 @@
 #include "AHCommon.hpp"
 
 #include <iostream>
+#include <osdialog.h>
 
 using namespace ah;
 
@@ -59,16 +60,30 @@ struct Bombe : core::AHModule {
 		paramQuantities[Y_PARAM]->description = "The deviation of the next chord update from the mode rule";
 
 		for(int i = 0; i < BUFFERSIZE; i++) {
-			buffer[i].setVoltages(music::defaultChord.formula, offset);
+			buffer[i].setVoltages(music::defaultChord.formula, offset, rng);
 		}
 
+		publishHistory();
+		resetTransitions();
+
 	}
 
 	void process(const ProcessArgs &args) override;
-	void modeRandom(BombeChord lastValue, float y);
-	void modeSimple(BombeChord lastValue, float y);
-	void modeKey(BombeChord lastValue, float y);
-	void modeGalaxy(BombeChord lastValue, float y);
+	void compileWalk(float y);
+	void prepareNextChord(float y);
+	void resetTransitions();
+
+	// Called from the UI thread, process() picks up the new table
+	void setTransitions(const music::DegreeTransitions &t) {
+		editedTransitions = t;
+		customTransitions = true;
+		publishTransitions();
+	}
+
+	void publishTransitions() {
+		transitionsBuffer.getBack() = editedTransitions;
+		transitionsBuffer.publish();
+	}
 
 	json_t *dataToJson() override {
 		json_t *rootJ = json_object();
@@ -85,6 +100,27 @@ struct Bombe : core::AHModule {
 		json_t *inversionsJ = json_integer((int) allowedInversions);
 		json_object_set_new(rootJ, "inversions", inversionsJ);
 
+		// transitions
+		if (customTransitions) {
+			json_object_set_new(rootJ, "transitions", editedTransitions.toJson());
+		}
+
+		// random
+		json_object_set_new(rootJ, "random", rng.toJson());
+
+		// chords, with a fixed seed the loop is saved too so that a reload carries on the same walk
+		if (rng.fixed) {
+			json_t *chordsJ = json_array();
+			for (int i = 0; i < BUFFERSIZE; i++) {
+				json_t *chordJ = buffer[i].toJson();
+				json_object_set_new(chordJ, "key", json_integer(buffer[i].key));
+				json_object_set_new(chordJ, "mode", json_integer(buffer[i].mode));
+				json_array_append_new(chordsJ, chordJ);
+			}
+			json_object_set_new(rootJ, "chords", chordsJ);
+			json_object_set_new(rootJ, "head", json_integer(head));
+		}
+
 		return rootJ;
 	}
 
@@ -105,12 +141,41 @@ struct Bombe : core::AHModule {
 		if (inversionsJ)
 			allowedInversions = json_integer_value(inversionsJ);
 
+		// transitions
+		json_t *transitionsJ = json_object_get(rootJ, "transitions");
+		music::DegreeTransitions t;
+		if (transitionsJ && t.fromJson(transitionsJ)) {
+			setTransitions(t);
+		}
+
+		// random
+		json_t *randomJ = json_object_get(rootJ, "random");
+		if (randomJ)
+			rng.fromJson(randomJ);
+
+		// chords
+		json_t *chordsJ = json_object_get(rootJ, "chords");
+		json_t *headJ = json_object_get(rootJ, "head");
+		if (json_array_size(chordsJ) == BUFFERSIZE && json_is_integer(headJ)) {
+			for (int i = 0; i < BUFFERSIZE; i++) {
+				json_t *chordJ = json_array_get(chordsJ, i);
+				if (buffer[i].fromJson(chordJ)) {
+					buffer[i].key = json_integer_value(json_object_get(chordJ, "key"));
+					buffer[i].mode = json_integer_value(json_object_get(chordJ, "mode"));
+				}
+			}
+			head = json_integer_value(headJ) & (BUFFERSIZE - 1);
+			historyDirty = true;
+		}
+
+		// The next chord is drawn again from the loaded stream
+		nextValid = false;
+
 	}
 
 //	const static int N_CHORDS = 98;
 
 //	int ChordMap[N_CHORDS] = {1,2,26,29,71,28,72,91,31,97,25,44,54,61,78,95,10,14,15,17,48,79,81,85,11,30,89,94,24,3,90,98,96,60,55,86,5,93,7,56,92,16,32,46,62,77,18,49,65,68,70,82,20,22,23,45,83,87,6,21,27,42,80,9,52,69,76,13,37,88,53,58,8,41,57,47,64,73,19,50,59,66,74,12,35,38,63,33,34,51,4,36,40,43,84,67,39,75};
- 	int MajorScale[7] = {0,2,4,5,7,9,11};
 	int Quality2Chord[N_QUALITIES] = { 0, 1, 54 }; // M, m, dim
 	int QualityMap[3][QMAP_SIZE] = { 
 		{00,00,00,00,00,00,00,00,00,00,07,07,07,07,07,07,07,07,06,06},	// M Maj7 7
@@ -139,19 +204,122 @@ struct Bombe : core::AHModule {
 
 	music::KnownChords knownChords;
 
-	std::string rootName = "";
-	std::string modeName = "";
+	digital::Random rng;
+	digital::SeedRequest seedRequest;
+
+	std::atomic<music::KeyModeState> keyState {music::KeyModeState()};
+
+	const static int BUFFERSIZE = 16; // Must be a power of 2
+	BombeChord buffer[BUFFERSIZE]; // Ring buffer, buffer[head] is the current chord
+	int head = 0;
+
+	// i = 0 is the current chord, i = 1 the one before it etc.
+	BombeChord &getChord(int i) {
+		return buffer[(head - i) & (BUFFERSIZE - 1)];
+	}
 
-	const static int BUFFERSIZE = 16;
-	BombeChord buffer[BUFFERSIZE];
-	BombeChord displayBuffer[BUFFERSIZE];
+	// Immutable copy of the most recent chords for BombeDisplay
+	const static int HISTORYSIZE = 7;
+	struct History {
+		BombeChord chords[HISTORYSIZE];
+	};
+	core::TripleBuffer<History> history;
+
+	void publishHistory() {
+		History &h = history.getBack();
+		for (int i = 0; i < HISTORYSIZE; i++) {
+			h.chords[i] = getChord(i);
+		}
+		history.publish();
+	}
+
+	bool historyDirty = false;
+
+	// The settings that the next chord depends on
+	struct ChordSettings {
+		int length;
+		int key;
+		int mode;
+		int selection;
+		int inversions;
+		int offset;
+
+		bool operator==(const ChordSettings &other) const {
+			return length == other.length && key == other.key && mode == other.mode && 
+				selection == other.selection && inversions == other.inversions && offset == other.offset;
+		}
+	};
+
+	ChordSettings getSettings() {
+		ChordSettings settings;
+		settings.length = length;
+		settings.key = currRoot;
+		settings.mode = currMode;
+		settings.selection = mode;
+		settings.inversions = allowedInversions;
+		settings.offset = offset;
+		return settings;
+	}
+
+	// The next chord is calculated speculatively between clocks, so that the clock edge only has to commit it.
+	// Changes in Y only cause a recalculation every REFRESH samples, as it may be under continuous CV control,
+	// but a clock always commits a chord prepared with the current Y
+	const static int REFRESH = 64;
+	BombeChord nextChord;
+	digital::Random nextRng; // The stream after nextChord was drawn, taken on when it is used
+	ChordSettings nextSettings;
+	float nextY = 0.0f;
+	bool nextValid = false;
+	int nextAge = 0;
+
+	// The selection rules compiled into alias tables, rebuilt only when the settings or Y change, so that
+	// choosing a chord is a handful of O(1) draws
+	const static int MAX_CHORDS = 128;
+	enum Strategy {
+		SIMPLE,
+		KEY,
+		RANDOM
+	};
+	struct Walk {
+		digital::AliasTable<3> strategy;
+		digital::AliasTable<N_DEGREES> degree[N_DEGREES + 1];
+		int root[N_DEGREES];
+		int quality[N_DEGREES];
+		digital::AliasTable<MAX_CHORDS> simpleChord[3];
+		digital::AliasTable<MAX_CHORDS> keyChord;
+		digital::AliasTable<N_NOTES> randomRoot;
+		digital::AliasTable<MAX_CHORDS> randomChord;
+		digital::AliasTable<3> inversion;
+	};
+	Walk walk;
+	ChordSettings walkSettings;
+	float walkY = 0.0f;
+	bool walkValid = false;
+
+	music::DegreeTransitions transitions; // Used by compileWalk()
+	music::DegreeTransitions editedTransitions; // Last table set from the UI thread
+	core::TripleBuffer<music::DegreeTransitions> transitionsBuffer;
+	bool customTransitions = false;
 
 };
 
 void Bombe::process(const ProcessArgs &args) {
 
+	core::ProcessTimer timer(this);
+
 	AHModule::step();
 
+	// The next chord was drawn from the old stream
+	if (seedRequest.apply(rng)) {
+		nextValid = false;
+	}
+
+	if (transitionsBuffer.isFresh()) {
+		transitions = transitionsBuffer.read();
+		walkValid = false;
+		nextValid = false;
+	}
+
 	// Get inputs from Rack
 	bool clocked = clockTrigger.process(inputs[CLOCK_INPUT].getVoltage());
 	bool locked = false;
@@ -179,76 +347,53 @@ void Bombe::process(const ProcessArgs &args) {
 		locked = true;
 	}
 
-	switch(mode) {
-		case 0: // Random
-			rootName = "";
-			modeName = "";
-			break;
-		case 1: // Simple
-			rootName = music::NoteDegreeModeNames[currRoot][0][currMode];
-			modeName = music::modeNames[currMode];
-			break;
-		case 2: // Galaxy
-			rootName = music::NoteDegreeModeNames[currRoot][0][currMode];
-			modeName = music::modeNames[currMode];
-			break;
-		default:
-			rootName = "";
-			modeName = "";
+	music::KeyModeState state = {};
+	state.selection = mode;
+	state.key = currRoot;
+	state.mode = currMode;
+	keyState.store(state, std::memory_order_relaxed);
+
+	ChordSettings settings = getSettings();
+	if (nextAge < REFRESH) {
+		nextAge++;
 	}
 
 	if (clocked) {
 
-		// Grab value from last element of sub-array, which will be the new head value
-		BombeChord lastValue = buffer[length - 1];
+		// Update the chord unless the buffer is locked or the update is skipped
+		digital::Random undecided = rng;
+		updated = !locked && rng.uniform() >= x;
 
-		// Shift buffer
-		for(int i = length - 1; i > 0; i--) {
-			buffer[i] = buffer[i-1];
+		if (updated) {
+			if (!(nextValid && nextSettings == settings && nextY == y)) {
+				// Settings or Y changed since the next chord was prepared, so we have to do it now
+				rng = undecided;
+				prepareNextChord(y);
+			}
+			rng = nextRng;
 		}
 
-		// Set first element
-		if (locked) {
-			// Buffer is locked
-			buffer[0] = lastValue;
-		} else {
-
-			if (random::uniform() < x) {
-				// Buffer update skipped
-				buffer[0] = lastValue;
-			} else {
-				
-				// We are going to update this entry 
-				updated = true;
-
-				switch(mode) {
-					case 0:	modeRandom(lastValue, y); break;
-					case 1:	modeSimple(lastValue, y); break;
-					case 2:	modeGalaxy(lastValue, y); break;
-					default: modeSimple(lastValue, y);
-				}
+		// Grab value from last element of the loop, which will be the new head value
+		BombeChord lastValue = getChord(length - 1);
 
-				music::InversionDefinition &invDef = knownChords.chords[buffer[0].chord].inversions[buffer[0].inversion];
-				buffer[0].setVoltages(invDef.formula, offset);
+		// Move the head on, overwriting the oldest entry
+		head = (head + 1) & (BUFFERSIZE - 1);
 
-			}
+		// Set first element
+		if (updated) {
+			buffer[head] = nextChord;
+		} else {
+			buffer[head] = lastValue;
 		}
 
-		for(int i = BUFFERSIZE - 1; i > 0; i--) {
-			displayBuffer[i] = displayBuffer[i-1];
-		}
-		displayBuffer[0] = buffer[0];
-
-		// for(int i = 0; i < BUFFERSIZE; i++) {
-		// 	std::cout << displayBuffer[i].chord << ",";
-		// }
-		// std::cout << std::endl;
-
-		// for(int i = 0; i < BUFFERSIZE; i++) {
-		// 	std::cout << displayBuffer[i].rootNote << ",";
-		// }
-		// std::cout << std::endl << std::endl;
-		
+		nextValid = false;
+		historyDirty = true;
+
+	} else if (historyDirty) {
+		publishHistory();
+		historyDirty = false;
+	} else if (!nextValid || !(nextSettings == settings) || (nextY != y && nextAge >= REFRESH)) {
+		prepareNextChord(y);
 	}
 
 	if (updated) { // Green Update
@@ -265,91 +410,182 @@ void Bombe::process(const ProcessArgs &args) {
 	// Set the output pitches 
 	outputs[PITCH_OUTPUT].setChannels(6);
 	for (int i = 0; i < NUM_PITCHES; i++) {
-		outputs[PITCH_OUTPUT].setVoltage(buffer[0].outVolts[i], i);
-		outputs[PITCH_OUTPUT + i].setVoltage(buffer[0].outVolts[i]);
+		outputs[PITCH_OUTPUT].setVoltage(buffer[head].outVolts[i], i);
+		outputs[PITCH_OUTPUT + i].setVoltage(buffer[head].outVolts[i]);
 	}
 }
 
-void Bombe::modeSimple(BombeChord lastValue, float y) {
-
-	// Recalculate new value of buffer[0].outVolts from lastValue
-	int shift = (rand() % (N_DEGREES - 1)) + 1; // 1 - 6 - always new chord
-	buffer[0].modeDegree = (lastValue.modeDegree + shift) % N_DEGREES; // FIXME, come from mode2 modeDeg == -1!
+void Bombe::compileWalk(float y) {
 
-	// quality 0 = Maj, 1 = Min, 2 = Dim
-	music::getRootFromMode(currMode,currRoot,buffer[0].modeDegree,&(buffer[0].rootNote),&(buffer[0].quality));
+	float weights[MAX_CHORDS];
+	int nChords = std::min((int)knownChords.chords.size(), (int)MAX_CHORDS);
 
-	if (random::uniform() < y) {
-		buffer[0].chord = QualityMap[buffer[0].quality][rand() % QMAP_SIZE]; // Get the index into the main chord table
-	} else {
-		buffer[0].chord = Quality2Chord[buffer[0].quality]; // Get the index into the main chord table
+	// How the next chord is chosen, Galaxy deviates from the mode with probability Y, up to 20% of the time into any chord in the key
+	switch(mode) {
+		case 0:
+			weights[SIMPLE] = 0.0f;
+			weights[KEY] = 0.0f;
+			weights[RANDOM] = 1.0f;
+			break;
+		case 2:
+			weights[SIMPLE] = 1.0f - y;
+			weights[KEY] = std::min(y, 0.2f);
+			weights[RANDOM] = std::max(0.0f, y - 0.2f);
+			break;
+		default:
+			weights[SIMPLE] = 1.0f;
+			weights[KEY] = 0.0f;
+			weights[RANDOM] = 0.0f;
 	}
+	walk.strategy.build(weights, 3);
 
-	buffer[0].inversion = InversionMap[allowedInversions][rand() % QMAP_SIZE];
-	buffer[0].key = currRoot;
-	buffer[0].mode = currMode;
+	// Walk through the degrees of the mode
+	for (int from = 0; from <= N_DEGREES; from++) {
+		walk.degree[from].build(transitions.weights[from], N_DEGREES);
+	}
 
-}
+	// quality 0 = Maj, 1 = Min, 2 = Dim
+	for (int d = 0; d < N_DEGREES; d++) {
+		music::getRootFromMode(currMode, currRoot, d, &(walk.root[d]), &(walk.quality[d]));
+	}
 
-void Bombe::modeRandom(BombeChord lastValue, float y) {
+	// The basic chord of the quality, or with probability Y one of its extensions
+	for (int q = 0; q < 3; q++) {
+		std::fill(weights, weights + nChords, 0.0f);
+		weights[Quality2Chord[q]] += 1.0f - y;
+		for (int i = 0; i < QMAP_SIZE; i++) {
+			weights[QualityMap[q][i]] += y / QMAP_SIZE;
+		}
+		walk.simpleChord[q].build(weights, nChords);
+	}
 
-	// Recalculate new value of buffer[0].outVolts from lastValue
-	float p = random::uniform();
-	if (p < y) {
-		buffer[0].rootNote = rand() % 12; 
-	} else {
-		buffer[0].rootNote = MajorScale[rand() % 7]; 
+	// Any chord bar the last
+	std::fill(weights, weights + nChords, 1.0f);
+	weights[nChords - 1] = 0.0f;
+	walk.keyChord.build(weights, nChords);
+
+	// Any note with probability Y, otherwise the major scale
+	music::PitchClassSet major = music::ScaleSets[music::SCALE_IONIAN];
+	for (int n = 0; n < N_NOTES; n++) {
+		weights[n] = y / N_NOTES;
+		if (major.contains(n)) {
+			weights[n] += (1.0f - y) / major.size();
+		}
 	}
+	walk.randomRoot.build(weights, N_NOTES);
 
-	buffer[0].modeDegree = -1; 
-	buffer[0].quality = -1; 
-	buffer[0].key = -1; 
-	buffer[0].mode = -1; 
+	// The higher Y, the further into the chord table. Major and minor chords always allowed
+	int nRandom = std::max(2, (int)((float)(knownChords.chords.size()) * y));
+	std::fill(weights, weights + nChords, 0.0f);
+	std::fill(weights, weights + std::min(nRandom, nChords), 1.0f);
+	walk.randomChord.build(weights, nChords);
 
-	float index = (float)(knownChords.chords.size()) * y;
+	std::fill(weights, weights + 3, 0.0f);
+	for (int i = 0; i < QMAP_SIZE; i++) {
+		weights[InversionMap[allowedInversions][i]] += 1.0f;
+	}
+	walk.inversion.build(weights, 3);
 
-	buffer[0].chord = rand() % std::max(2, (int)index); // Major and minor chords always allowed
-	buffer[0].inversion = InversionMap[allowedInversions][rand() % QMAP_SIZE];
+	walkSettings = getSettings();
+	walkY = y;
+	walkValid = true;
 
 }
 
-void Bombe::modeKey(BombeChord lastValue, float y) {
-
-	int shift = (rand() % (N_DEGREES - 1)) + 1; // 1 - 6 - always new chord
-	buffer[0].modeDegree = (lastValue.modeDegree + shift) % N_DEGREES; // FIXME, come from mode2 modeDeg == -1!
+void Bombe::prepareNextChord(float y) {
 
-	music::getRootFromMode(currMode,currRoot,buffer[0].modeDegree,&(buffer[0].rootNote),&(buffer[0].quality));
+	if (!walkValid || !(walkSettings == getSettings()) || walkY != y) {
+		compileWalk(y);
+	}
 
-	buffer[0].chord = (rand() % (knownChords.chords.size() - 1)); // Get the index into the main chord table
-	buffer[0].inversion = InversionMap[allowedInversions][rand() % QMAP_SIZE];
-	buffer[0].key = currRoot;
-	buffer[0].mode = currMode;
+	BombeChord &lastValue = getChord(length - 1);
 
-}
+	// Draw from a copy of the stream as it will be after the update decision on the next clock, so that the stream
+	// only moves on when the chord is used and a fixed seed reloaded from the patch prepares the same chord again
+	nextRng = rng;
+	nextRng.uniform();
 
-void Bombe::modeGalaxy(BombeChord lastValue, float y) {
+	int strategy = walk.strategy.sample(nextRng.uniform());
+	if (strategy == RANDOM) {
 
-	float excess = y - random::uniform();
+		nextChord.rootNote = walk.randomRoot.sample(nextRng.uniform());
+		nextChord.modeDegree = -1; 
+		nextChord.quality = -1; 
+		nextChord.key = -1; 
+		nextChord.mode = -1; 
+		nextChord.chord = walk.randomChord.sample(nextRng.uniform());
 
-	if (excess < 0.0) {
-		modeSimple(lastValue, y);
 	} else {
-		if (excess < 0.2) {
-			modeKey(lastValue, y);
+
+		// Chords from outside the mode use the last row of the transitions
+		int from = lastValue.modeDegree < 0 ? N_DEGREES : lastValue.modeDegree;
+		int degree = walk.degree[from].sample(nextRng.uniform());
+
+		nextChord.modeDegree = degree;
+		nextChord.rootNote = walk.root[degree];
+		nextChord.quality = walk.quality[degree];
+		nextChord.key = currRoot;
+		nextChord.mode = currMode;
+
+		if (strategy == SIMPLE) {
+			nextChord.chord = walk.simpleChord[nextChord.quality].sample(nextRng.uniform());
 		} else {
-			modeRandom(lastValue, y);
+			nextChord.chord = walk.keyChord.sample(nextRng.uniform());
 		}
+
 	}
 
+	nextChord.inversion = walk.inversion.sample(nextRng.uniform());
+
+	music::InversionDefinition &invDef = knownChords.chords[nextChord.chord].inversions[nextChord.inversion];
+	nextChord.setVoltages(invDef.formula, offset, nextRng);
+
+	nextSettings = getSettings();
+	nextY = y;
+	nextValid = true;
+	nextAge = 0;
+
 }
 
-struct BombeDisplay : TransparentWidget {
+void Bombe::resetTransitions() {
+	// Always move to a new degree, after a chord from outside the mode never to the 7th
+	for (int from = 0; from <= N_DEGREES; from++) {
+		for (int to = 0; to < N_DEGREES; to++) {
+			editedTransitions.weights[from][to] = (from == to || (from == N_DEGREES && to == N_DEGREES - 1)) ? 0.0f : 1.0f;
+		}
+	}
+	customTransitions = false;
+	publishTransitions();
+}
+
+struct BombeDisplay : gui::SnapshotDisplay {
 	
 	Bombe *module;
 	std::shared_ptr<Font> font;
 
+	Bombe::History history;
+	music::KeyModeState state = {};
+
 	BombeDisplay() {
-		font = APP->window->loadFont(asset::plugin(pluginInstance, "res/EurostileBold.ttf"));
+		font = gui::getFont(gui::FONT_EUROSTILE);
+	}
+
+	bool snapshot() override {
+
+		if (module == NULL) {
+			return false;
+		}
+
+		const Bombe::History &h = module->history.read();
+		music::KeyModeState s = module->keyState.load(std::memory_order_relaxed);
+		if (!memcmp(&h, &history, sizeof(Bombe::History)) && !memcmp(&s, &state, sizeof(music::KeyModeState))) {
+			return false;
+		}
+
+		history = h;
+		state = s;
+		return true;
+
 	}
 
 	void draw(const DrawArgs &ctx) override {
@@ -365,12 +601,12 @@ struct BombeDisplay : TransparentWidget {
 
 		char text[128];
 
-		for (int i = 0; i < 7; i++)  {
+		for (int i = 0; i < Bombe::HISTORYSIZE; i++)  {
 
 			std::string chordName = "";
 			std::string chordExtName = "";
 
-			BombeChord &bC = module->displayBuffer[i];
+			const BombeChord &bC = history.chords[i];
 
 			music::InversionDefinition &invDef = module->knownChords.chords[bC.chord].inversions[bC.inversion];
 
@@ -392,17 +628,27 @@ struct BombeDisplay : TransparentWidget {
 
 		nvgFillColor(ctx.vg, nvgRGBA(0x00, 0xFF, 0xFF, 0xFF));
 
-		nvgTextAlign(ctx.vg, NVG_ALIGN_RIGHT);
-		snprintf(text, sizeof(text), "%s", module->rootName.c_str());
-		nvgText(ctx.vg, box.size.x - 5, box.pos.y, text, NULL);
-
-		snprintf(text, sizeof(text), "%s", module->modeName.c_str());
-		nvgText(ctx.vg, box.size.x - 5, box.pos.y + 11, text, NULL);
+		if (state.selection == 1 || state.selection == 2) { // Simple, Galaxy
+			nvgTextAlign(ctx.vg, NVG_ALIGN_RIGHT);
+			nvgText(ctx.vg, box.size.x - 5, box.pos.y, music::NoteDegreeModeNames[state.key][0][state.mode].c_str(), NULL);
+			nvgText(ctx.vg, box.size.x - 5, box.pos.y + 11, music::modeNames[state.mode].c_str(), NULL);
+		}
 
 	}
 	
 };
 
+static void loadTransitions(Bombe *module) {
+	char *path = osdialog_file(OSDIALOG_OPEN, asset::user("").c_str(), "transitions.json", NULL);
+	if (path) {
+		music::DegreeTransitions t;
+		if (t.load(path)) {
+			module->setTransitions(t);
+		}
+		free(path);
+	}
+}
+
 struct BombeWidget : ModuleWidget {
 
 	BombeWidget(Bombe *module)  {
@@ -452,7 +698,7 @@ struct BombeWidget : ModuleWidget {
 			BombeDisplay *displayW = createWidget<BombeDisplay>(Vec(0, 20));
 			displayW->box.size = Vec(240, 230);
 			displayW->module = module;
-			addChild(displayW);
+			addChild(new gui::DisplayCache(displayW));
 		}
 
 	}
@@ -486,6 +732,20 @@ struct BombeWidget : ModuleWidget {
 			}
 		};
 
+		struct TransitionsItem : MenuItem {
+			Bombe *module;
+			void onAction(const rack::event::Action &e) override {
+				loadTransitions(module);
+			}
+		};
+
+		struct ResetTransitionsItem : MenuItem {
+			Bombe *module;
+			void onAction(const rack::event::Action &e) override {
+				module->resetTransitions();
+			}
+		};
+
 		struct OffsetMenu : MenuItem {
 			Bombe *module;
 			Menu *createChildMenu() override {
@@ -547,6 +807,23 @@ struct BombeWidget : ModuleWidget {
 		invItem->module = bombe;
 		menu->addChild(invItem);
 
+		TransitionsItem *transItem = createMenuItem<TransitionsItem>("Load transition matrix", CHECKMARK(bombe->customTransitions));
+		transItem->module = bombe;
+		menu->addChild(transItem);
+
+		ResetTransitionsItem *resetTransItem = createMenuItem<ResetTransitionsItem>("Reset transition matrix");
+		resetTransItem->module = bombe;
+		menu->addChild(resetTransItem);
+
+		gui::SeedMenu *seedItem = createMenuItem<gui::SeedMenu>("Random seed");
+		seedItem->rng = &(bombe->rng);
+		seedItem->request = &(bombe->seedRequest);
+		menu->addChild(seedItem);
+
+		gui::ProcessTimeItem *timeItem = createMenuItem<gui::ProcessTimeItem>("Max process time");
+		timeItem->module = bombe;
+		menu->addChild(timeItem);
+
      }
 
 };
@@ -72,8 +72,10 @@ struct Circle : core::AHModule {
 
 	rack::dsp::PulseGenerator stepPulse;
 
-	int baseKeyIndex = 0;
-	int curKeyIndex = 0;
+	// Keys are pitch classes in both scalings, only the mapping of the KEY input and knob differs
+	static const int FIFTH = 7;
+	int baseKey = 0;
+	int curKey = 0;
 
 	int curMode = 0;
 
@@ -89,17 +91,20 @@ void Circle::process(const ProcessArgs &args) {
 	float rotLInput		= inputs[ROTL_INPUT].getVoltage();
 	float rotRInput		= inputs[ROTR_INPUT].getVoltage();
 	
-	int newKeyIndex = 0;
+	int newKey = 0;
 	int deg;
 	if (inputs[KEY_INPUT].isConnected()) {
 		float fRoot = inputs[KEY_INPUT].getVoltage();
 		if (voltScale == FIFTHS) {
-			newKeyIndex = music::getKeyFromVolts(fRoot);
+			newKey = music::CIRCLE_FIFTHS[music::getKeyFromVolts(fRoot)];
 		} else {
-			music::getPitchFromVolts(fRoot, music::NOTE_C, music::SCALE_CHROMATIC, &newKeyIndex, &deg);
+			music::getPitchFromVolts(fRoot, music::NOTE_C, music::SCALE_CHROMATIC, &newKey, &deg);
 		}
 	} else {
-		newKeyIndex = params[KEY_PARAM].getValue();
+		newKey = params[KEY_PARAM].getValue();
+		if (voltScale == FIFTHS) {
+			newKey = music::CIRCLE_FIFTHS[newKey];
+		}
 	}
 
 	int newMode = 0;
@@ -116,61 +121,28 @@ void Circle::process(const ProcessArgs &args) {
 	bool rotLStatus		= rotLTrigger.process(rotLInput);
 	bool rotRStatus		= rotRTrigger.process(rotRInput);
 
+	// Moving around the circle transposes the key by a fifth, whichever scaling the inputs use
 	if (rotLStatus) {
-		if (debugEnabled()) { std::cout << stepX << " Rotate left: " << curKeyIndex; }
-		if (voltScale == FIFTHS) {
-			if (curKeyIndex == 0) {
-				curKeyIndex = 11;
-			} else {
-				curKeyIndex--;
-			}
-		} else {
-			curKeyIndex = curKeyIndex + 5;
-			if (curKeyIndex > 11) {
-				curKeyIndex = curKeyIndex - 12;
-			}
-		}
-
-		if (debugEnabled()) { std::cout << " -> " << curKeyIndex << std::endl;	}
+		if (debugEnabled()) { std::cout << stepX << " Rotate left: " << curKey; }
+		curKey = eucMod(curKey - FIFTH, music::NUM_NOTES);
+		if (debugEnabled()) { std::cout << " -> " << curKey << std::endl;	}
 	} 
 
 	if (rotRStatus) {
-		if (debugEnabled()) { std::cout << stepX << " Rotate right: " << curKeyIndex; }
-		if (voltScale == FIFTHS) {
-			if (curKeyIndex == 11) {
-				curKeyIndex = 0;
-			} else {
-				curKeyIndex++;
-			}
-		} else {
-			curKeyIndex = curKeyIndex - 5;
-			if (curKeyIndex < 0) {
-				curKeyIndex = curKeyIndex + 12;
-			}
-		}
-		if (debugEnabled()) { std::cout << " -> " << curKeyIndex << std::endl;	}
+		if (debugEnabled()) { std::cout << stepX << " Rotate right: " << curKey; }
+		curKey = eucMod(curKey + FIFTH, music::NUM_NOTES);
+		if (debugEnabled()) { std::cout << " -> " << curKey << std::endl;	}
 	} 
 
 	if (rotLStatus && rotRStatus) {
-		if (debugEnabled()) { std::cout << stepX << " Reset " << curKeyIndex << std::endl;	}
-		curKeyIndex = baseKeyIndex;
+		if (debugEnabled()) { std::cout << stepX << " Reset " << curKey << std::endl;	}
+		curKey = baseKey;
 	}
 
-	if (newKeyIndex != baseKeyIndex) {
-		if (debugEnabled()) { std::cout << stepX << " New base: " << newKeyIndex << std::endl;}
-		baseKeyIndex = newKeyIndex;
-		curKeyIndex = newKeyIndex;
-	}
-
-	int curKey;
-	int baseKey;
-
-	if (voltScale == FIFTHS) {
-		curKey = music::CIRCLE_FIFTHS[curKeyIndex];
-		baseKey = music::CIRCLE_FIFTHS[baseKeyIndex];
-	} else {
-		curKey = curKeyIndex;
-		baseKey = baseKeyIndex;		
+	if (newKey != baseKey) {
+		if (debugEnabled()) { std::cout << stepX << " New base: " << newKey << std::endl;}
+		baseKey = newKey;
+		curKey = newKey;
 	}
 
 	float keyVolts = music::getVoltsFromKey(curKey);
@@ -1,10 +1,24 @@
 #include <iostream>
+#include <osdialog.h>
 
 #include "AH.hpp"
 #include "AHCommon.hpp"
 
 using namespace ah;
 
+// The last chord played, published by the audio thread for the widget to derive names from.
+// Kept to 8 bytes so that std::atomic<GalaxyChordState> is lock-free
+struct GalaxyChordState {
+	int8_t key;
+	int8_t mode;
+	int8_t rootNote;
+	int8_t chord;		// -1 = no chord yet
+	int8_t inversion;
+	int8_t modeDegree;	// -1 = not chosen from the mode
+	int8_t quality;
+	int8_t spare;
+};
+
 struct Galaxy : core::AHModule {
 
 	const static int NUM_PITCHES = 6;
@@ -89,13 +103,30 @@ struct Galaxy : core::AHModule {
 		configParam(BAD_PARAM, 0.0, 1.0, 0.0, "Bad", "%", 0.0f, 100.0f);
 		paramQuantities[BAD_PARAM]->description = "Deviation from chord selection rule for the mode";
 
+		resetTransitions();
+
 	}
 
 	void process(const ProcessArgs &args) override;
 
-	void getFromRandom();
-	void getFromKey();
-	void getFromKeyMode();
+	void compileWalk();
+	void prepareNextChord();
+	void resetTransitions();
+	void getFromRandom(music::Chord &chord);
+	void getFromKey(music::Chord &chord);
+	void getFromKeyMode(music::Chord &chord);
+
+	// Called from the UI thread, process() picks up the new table
+	void setTransitions(const music::DegreeTransitions &t) {
+		editedTransitions = t;
+		customTransitions = true;
+		publishTransitions();
+	}
+
+	void publishTransitions() {
+		transitionsBuffer.getBack() = editedTransitions;
+		transitionsBuffer.publish();
+	}
 
 	json_t *dataToJson() override {
 		json_t *rootJ = json_object();
@@ -112,6 +143,19 @@ struct Galaxy : core::AHModule {
 		json_t *inversionsJ = json_integer((int) allowedInversions);
 		json_object_set_new(rootJ, "inversions", inversionsJ);
 
+		// transitions
+		if (customTransitions) {
+			json_object_set_new(rootJ, "transitions", editedTransitions.toJson());
+		}
+
+		// random
+		json_object_set_new(rootJ, "random", rng.toJson());
+
+		// chord, with a fixed seed the walk carries on from it after a reload
+		if (rng.fixed) {
+			json_object_set_new(rootJ, "chord", currChord.toJson());
+		}
+
 		return rootJ;
 	}
 
@@ -132,6 +176,27 @@ struct Galaxy : core::AHModule {
 		if (inversionsJ)
 			allowedInversions = json_integer_value(inversionsJ);
 
+		// transitions
+		json_t *transitionsJ = json_object_get(rootJ, "transitions");
+		music::DegreeTransitions t;
+		if (transitionsJ && t.fromJson(transitionsJ)) {
+			setTransitions(t);
+		}
+
+		// random
+		json_t *randomJ = json_object_get(rootJ, "random");
+		if (randomJ)
+			rng.fromJson(randomJ);
+
+		// chord
+		json_t *chordJ = json_object_get(rootJ, "chord");
+		if (chordJ && currChord.fromJson(chordJ)) {
+			lastQuality = -1; // Light it on the next move
+		}
+
+		// The next chord is drawn again from the loaded stream
+		nextValid = false;
+
 	}
 
 	int GalaxyChords[N_QUALITIES] = { 0, 2, 83, 12, 1, 29 }; // M, 7, m7, M7, m, dim
@@ -154,6 +219,9 @@ struct Galaxy : core::AHModule {
 
 	music::KnownChords knownChords;
 
+	digital::Random rng;
+	digital::SeedRequest seedRequest;
+
 	int lastQuality = 0;
 	int lastNoteIndex = 0; 
 	int lastInversion = 0;
@@ -169,17 +237,94 @@ struct Galaxy : core::AHModule {
 	int mode = 1;				// 0 = random chord, 1 = chord in key, 2 = chord in mode
 	int allowedInversions = 0;	// 0 = root only, 1 = root + first, 2 = root, first, second
 
-	std::string rootName = "";
-	std::string modeName = "";
+	std::atomic<music::KeyModeState> keyState {music::KeyModeState()};
+	std::atomic<GalaxyChordState> chordState {getEmptyChordState()};
+
+	static GalaxyChordState getEmptyChordState() {
+		GalaxyChordState state = {};
+		state.chord = -1;
+		state.modeDegree = -1;
+		return state;
+	}
+
+	// The settings that the next chord depends on
+	struct ChordSettings {
+		int key;
+		int mode;
+		int selection;
+		int inversions;
+		int offset;
+		float bad;
+
+		bool operator==(const ChordSettings &other) const {
+			return key == other.key && mode == other.mode && selection == other.selection && 
+				inversions == other.inversions && offset == other.offset && bad == other.bad;
+		}
+	};
+
+	ChordSettings getSettings() {
+		ChordSettings settings;
+		settings.key = currRoot;
+		settings.mode = currMode;
+		settings.selection = mode;
+		settings.inversions = allowedInversions;
+		settings.offset = offset;
+		settings.bad = params[BAD_PARAM].getValue();
+		return settings;
+	}
+
+	// The next chord is calculated speculatively between moves, so that the move trigger only has to commit it
+	music::Chord nextChord;
+	digital::Random nextRng; // The stream after nextChord was drawn, taken on when it is used
+	ChordSettings nextSettings;
+	int nextBadLight = 0;
+	bool nextHaveMode = false;
+	bool nextValid = false;
+
+	// The selection rules compiled into alias tables, rebuilt only when the settings change
+	enum Strategy {
+		MODE,
+		KEY,
+		RANDOM
+	};
+	struct Walk {
+		digital::AliasTable<3> strategy;
+		digital::AliasTable<3> rotate;
+		digital::AliasTable<5> radial;
+		digital::AliasTable<music::NUM_DEGREES> degree[music::NUM_DEGREES];
+		int root[music::NUM_DEGREES];
+		int modeQuality[music::NUM_DEGREES];
+		digital::AliasTable<N_QUALITIES> quality[3];
+		digital::AliasTable<3> inversion;
+	};
+	Walk walk;
+	ChordSettings walkSettings;
+	bool walkValid = false;
+
+	music::DegreeTransitions transitions; // Used by compileWalk()
+	music::DegreeTransitions editedTransitions; // Last table set from the UI thread
+	core::TripleBuffer<music::DegreeTransitions> transitionsBuffer;
+	bool customTransitions = false;
 
-	std::string chordName = "";
-	std::string chordExtName = "";
 };
 
 void Galaxy::process(const ProcessArgs &args) {
 
+	core::ProcessTimer timer(this);
+
 	AHModule::step();
 
+	// The next chord was drawn from the old stream
+	if (seedRequest.apply(rng)) {
+		nextValid = false;
+	}
+
+	if (transitionsBuffer.isFresh()) {
+		transitions = transitionsBuffer.read();
+		walkValid = false;
+		nextValid = false;
+	}
+
 	int badLight = 0;
 
 	// Get inputs from Rack
@@ -199,59 +344,28 @@ void Galaxy::process(const ProcessArgs &args) {
 		currRoot = params[KEY_PARAM].getValue();
 	}
 
-	if (mode == 1) {
-		rootName = music::noteNames[currRoot];
-		modeName = "";
-	} else if (mode == 2) {
-		rootName = music::NoteDegreeModeNames[currRoot][0][currMode];
-		modeName = music::modeNames[currMode];
-	} else {
-		rootName = "";
-		modeName = "";
-		chordExtName = "";
-	}
+	music::KeyModeState state = {};
+	state.selection = mode;
+	state.key = currRoot;
+	state.mode = currMode;
+	keyState.store(state, std::memory_order_relaxed);
+
+	ChordSettings settings = getSettings();
 
 	if (move) {
 
 		bool changed = false;
-		bool haveMode = false;
-
-		if (mode == 0) {
-			getFromRandom();
-		} else if (mode == 1) {
-
-			if (random::uniform() < params[BAD_PARAM].getValue()) {
-				badLight = 2;
-				getFromRandom();
-			} else {
-				getFromKey();
-			}
-
-		} else if (mode == 2) {
-
-			float excess = params[BAD_PARAM].getValue() - random::uniform();
-
-			if (excess < 0.0) {
-				getFromKeyMode();
-				haveMode = true;
-			} else {
-				if (excess < 0.2) {
-					badLight = 1;
-					getFromKey();
-				} else {
-					badLight = 2;
-					getFromRandom();
-				}
-			}
 
+		if (!(nextValid && nextSettings == settings)) {
+			// Settings changed since the next chord was prepared, so we have to do it now
+			prepareNextChord();
 		}
 
-		currChord.inversion = InversionMap[allowedInversions][rand() % QMAP_SIZE];
-		currChord.chord = GalaxyChords[currChord.quality];
-
-		music::ChordDefinition &chordDef = knownChords.chords[currChord.chord];
-		music::InversionDefinition &invDef = chordDef.inversions[currChord.inversion];
-		currChord.setVoltages(invDef.formula, offset);
+		currChord = nextChord;
+		rng = nextRng;
+		badLight = nextBadLight;
+		bool haveMode = nextHaveMode;
+		nextValid = false;
 
 		if (currChord.quality != lastQuality) {
 			changed = true;
@@ -272,18 +386,15 @@ void Galaxy::process(const ProcessArgs &args) {
 
 		if (changed) {
 
-			if (mode == 2) {
-				if (haveMode) {
-					chordName = invDef.getName(currMode, currRoot, currChord.modeDegree, currChord.rootNote);
-					chordExtName = degNames[currChord.modeDegree * 6 + currChord.quality];
-				} else {
-					chordName = invDef.getName(currChord.rootNote);
-					chordExtName = "";
-				} 
-			} else {
-				chordName = invDef.getName(currChord.rootNote);
-				chordExtName = "";
-			}
+			GalaxyChordState chord = {};
+			chord.key = currRoot;
+			chord.mode = currMode;
+			chord.rootNote = currChord.rootNote;
+			chord.chord = currChord.chord;
+			chord.inversion = currChord.inversion;
+			chord.modeDegree = (mode == 2 && haveMode) ? currChord.modeDegree : -1;
+			chord.quality = currChord.quality;
+			chordState.store(chord, std::memory_order_relaxed);
 
 			lights[NOTE_LIGHT + light].setBrightness(0.0f);
 			lights[NOTE_LIGHT + newlight].setBrightness(10.0f);
@@ -291,6 +402,8 @@ void Galaxy::process(const ProcessArgs &args) {
 
 		}
 
+	} else if (!nextValid || !(nextSettings == settings)) {
+		prepareNextChord();
 	}
 
 	if (badLight == 1) { // Green (scale->key)
@@ -313,78 +426,208 @@ void Galaxy::process(const ProcessArgs &args) {
 
 }
 
-void Galaxy::getFromRandom() {
+void Galaxy::compileWalk() {
+
+	float bad = params[BAD_PARAM].getValue();
+	float weights[N_NOTES];
+
+	// How the next chord is chosen
+	switch(mode) {
+		case 0:
+			weights[MODE] = 0.0f;
+			weights[KEY] = 0.0f;
+			weights[RANDOM] = 1.0f;
+			break;
+		case 1:
+			weights[MODE] = 0.0f;
+			weights[KEY] = 1.0f - bad;
+			weights[RANDOM] = bad;
+			break;
+		default:
+			weights[MODE] = 1.0f - bad;
+			weights[KEY] = std::min(bad, 0.2f);
+			weights[RANDOM] = std::max(0.0f, bad - 0.2f);
+	}
+	walk.strategy.build(weights, 3);
+
+	// Moves around the grid, steps of -1..1 around the circle and -2..2 along the radius
+	float rotate[3] = {1.0f, 0.0f, 1.0f};
+	walk.rotate.build(rotate, 3);
+	float radial[5] = {1.0f, 1.0f, 0.0f, 1.0f, 1.0f};
+	walk.radial.build(radial, 5);
+
+	// Moves through the mode
+	for (int from = 0; from < music::NUM_DEGREES; from++) {
+		walk.degree[from].build(transitions.weights[from], music::NUM_DEGREES);
+		music::getRootFromMode(currMode, currRoot, from, &(walk.root[from]), &(walk.modeQuality[from]));
+	}
+
+	for (int q = 0; q < 3; q++) {
+		std::fill(weights, weights + N_QUALITIES, 0.0f);
+		for (int i = 0; i < QMAP_SIZE; i++) {
+			weights[QualityMap[q][i]] += 1.0f;
+		}
+		walk.quality[q].build(weights, N_QUALITIES);
+	}
+
+	std::fill(weights, weights + 3, 0.0f);
+	for (int i = 0; i < QMAP_SIZE; i++) {
+		weights[InversionMap[allowedInversions][i]] += 1.0f;
+	}
+	walk.inversion.build(weights, 3);
+
+	walkSettings = getSettings();
+	walkValid = true;
+
+}
+
+void Galaxy::prepareNextChord() {
+
+	if (!walkValid || !(walkSettings == getSettings())) {
+		compileWalk();
+	}
 
-	int rotSign = rand() % 2 ? 1 : -1;
-	int rotateInput = rotSign * (rand() % 1 + 1); // -2 to 2
+	// Draw from a copy of the stream, so that it only moves on when the chord is used and a fixed seed reloaded
+	// from the patch prepares the same chord again
+	nextRng = rng;
 
-	int radSign = rand() % 2 ? 1 : -1;
-	int radialInput = radSign * (rand() % 2 + 1); // -2 to 2
+	nextChord = currChord;
+	nextBadLight = 0;
+	nextHaveMode = false;
+
+	switch(walk.strategy.sample(nextRng.uniform())) {
+		case MODE:
+			getFromKeyMode(nextChord);
+			nextHaveMode = true;
+			break;
+		case KEY:
+			if (mode == 2) {
+				nextBadLight = 1;
+			}
+			getFromKey(nextChord);
+			break;
+		default:
+			if (mode != 0) {
+				nextBadLight = 2;
+			}
+			getFromRandom(nextChord);
+	}
+
+	nextChord.inversion = walk.inversion.sample(nextRng.uniform());
+	nextChord.chord = GalaxyChords[nextChord.quality];
+
+	music::InversionDefinition &invDef = knownChords.chords[nextChord.chord].inversions[nextChord.inversion];
+	nextChord.setVoltages(invDef.formula, offset, nextRng);
+
+	nextSettings = getSettings();
+	nextValid = true;
+
+}
+
+void Galaxy::getFromRandom(music::Chord &chord) {
+
+	int rotateInput = walk.rotate.sample(nextRng.uniform()) - 1; // -1 to 1
+	int radialInput = walk.radial.sample(nextRng.uniform()) - 2; // -2 to 2
 
 	if(debugEnabled(5000)) {
 		std::cout << "Rotate: " << rotateInput << "  Radial: " << radialInput << std::endl;
 	}
 
 	// Determine move around the grid
-	currChord.quality += rotateInput;
-	currChord.quality = eucMod(currChord.quality, N_QUALITIES);
+	chord.quality += rotateInput;
+	chord.quality = eucMod(chord.quality, N_QUALITIES);
 
-	currChord.rootNote += radialInput;
-	currChord.rootNote = eucMod(currChord.rootNote, N_NOTES);
+	chord.rootNote += radialInput;
+	chord.rootNote = eucMod(chord.rootNote, N_NOTES);
 
 }
 
-void Galaxy::getFromKey() {
-
-	int rotSign = rand() % 2 ? 1 : -1;
-	int rotateInput = rotSign * (rand() % 1 + 1); // -2 to 2
+void Galaxy::getFromKey(music::Chord &chord) {
 
-	int radSign = rand() % 2 ? 1 : -1;
-	int radialInput = radSign * (rand() % 2 + 1); // -2 to 2
+	int rotateInput = walk.rotate.sample(nextRng.uniform()) - 1; // -1 to 1
+	int radialInput = walk.radial.sample(nextRng.uniform()) - 2; // -2 to 2
 
 	if(debugEnabled(5000)) {
 		std::cout << "Rotate: " << rotateInput << "  Radial: " << radialInput << std::endl;
 	}
 
 	// Determine move around the grid
-	currChord.quality += rotateInput;
-	currChord.quality = eucMod(currChord.quality, N_QUALITIES);
+	chord.quality += rotateInput;
+	chord.quality = eucMod(chord.quality, N_QUALITIES);
 
 	// Just major scale
 	int *curScaleArr = music::ASCALE_IONIAN;
 	int notesInScale = LENGTHOF(music::ASCALE_IONIAN);
 
 	// Determine move through the scale
-	currChord.modeDegree += radialInput; 
-	currChord.modeDegree = eucMod(currChord.modeDegree, notesInScale);
+	chord.modeDegree += radialInput; 
+	chord.modeDegree = eucMod(chord.modeDegree, notesInScale);
 
-	currChord.rootNote = (currRoot + curScaleArr[currChord.modeDegree]) % 12;
+	chord.rootNote = (currRoot + curScaleArr[chord.modeDegree]) % 12;
 
 }
 
-void Galaxy::getFromKeyMode() {
-
-	int rotSign = rand() % 2 ? 1 : -1;
-	int rotateInput = rotSign * (rand() % 1 + 1); // -2 to 2
+void Galaxy::getFromKeyMode(music::Chord &chord) {
 
 	// Determine move through the scale
-	currChord.modeDegree += rotateInput;
-	currChord.modeDegree = eucMod(currChord.modeDegree, music::NUM_DEGREES);
+	chord.modeDegree = walk.degree[eucMod(chord.modeDegree, music::NUM_DEGREES)].sample(nextRng.uniform());
 
 	// From the input root, mode and degree, we can get the root chord note and quality (Major,Minor,Diminshed)
-	int q;
-	music::getRootFromMode(currMode,currRoot,currChord.modeDegree,&(currChord.rootNote),&q);
-	currChord.quality = QualityMap[q][rand() % QMAP_SIZE];
+	chord.rootNote = walk.root[chord.modeDegree];
+	chord.quality = walk.quality[walk.modeQuality[chord.modeDegree]].sample(nextRng.uniform());
+
+}
 
+void Galaxy::resetTransitions() {
+	// One step either way through the mode
+	for (int from = 0; from <= music::NUM_DEGREES; from++) {
+		for (int to = 0; to < music::NUM_DEGREES; to++) {
+			int step = eucMod(to - from, music::NUM_DEGREES);
+			editedTransitions.weights[from][to] = (step == 1 || step == music::NUM_DEGREES - 1) ? 1.0f : 0.0f;
+		}
+	}
+	customTransitions = false;
+	publishTransitions();
 }
 
-struct GalaxyDisplay : TransparentWidget {
+struct GalaxyDisplay : gui::SnapshotDisplay {
 	
 	Galaxy *module;
 	std::shared_ptr<Font> font;
 
+	GalaxyChordState lastChord = Galaxy::getEmptyChordState();
+	music::KeyModeState state = {};
+	std::string chordName = "";
+	std::string chordExtName = "";
+
 	GalaxyDisplay() {
-		font = APP->window->loadFont(asset::plugin(pluginInstance, "res/EurostileBold.ttf"));
+		font = gui::getFont(gui::FONT_EUROSTILE);
+	}
+
+	// Names are only rebuilt when the module publishes a different chord
+	bool snapshot() override {
+
+		if (module == NULL) {
+			return false;
+		}
+
+		bool changed = false;
+
+		GalaxyChordState chord = module->chordState.load(std::memory_order_relaxed);
+		if (memcmp(&chord, &lastChord, sizeof(GalaxyChordState))) {
+			lastChord = chord;
+			updateNames(chord);
+			changed = true;
+		}
+
+		music::KeyModeState s = module->keyState.load(std::memory_order_relaxed);
+		if (memcmp(&s, &state, sizeof(music::KeyModeState))) {
+			state = s;
+			changed = true;
+		}
+
+		return changed;
+
 	}
 
 	void draw(const DrawArgs &ctx) override {
@@ -398,25 +641,54 @@ struct GalaxyDisplay : TransparentWidget {
 		nvgFillColor(ctx.vg, nvgRGBA(0x00, 0xFF, 0xFF, 0xFF));
 		nvgTextLetterSpacing(ctx.vg, -1);
 
-		char text[128];
+		nvgText(ctx.vg, box.pos.x + 5, box.pos.y, chordName.c_str(), NULL);
+		if (state.selection != 0) {
+			nvgText(ctx.vg, box.pos.x + 5, box.pos.y + 11, chordExtName.c_str(), NULL);
+		}
 
-		snprintf(text, sizeof(text), "%s", module->chordName.c_str());
-		nvgText(ctx.vg, box.pos.x + 5, box.pos.y, text, NULL);
+		nvgTextAlign(ctx.vg, NVG_ALIGN_RIGHT);
+		if (state.selection == 1) { // in Key
+			nvgText(ctx.vg, box.size.x - 5, box.pos.y, music::noteNames[state.key].c_str(), NULL);
+		} else if (state.selection == 2) { // in Mode
+			nvgText(ctx.vg, box.size.x - 5, box.pos.y, music::NoteDegreeModeNames[state.key][0][state.mode].c_str(), NULL);
+			nvgText(ctx.vg, box.size.x - 5, box.pos.y + 11, music::modeNames[state.mode].c_str(), NULL);
+		}
 
-		snprintf(text, sizeof(text), "%s", module->chordExtName.c_str());
-		nvgText(ctx.vg, box.pos.x + 5, box.pos.y + 11, text, NULL);
+	}
 
-		nvgTextAlign(ctx.vg, NVG_ALIGN_RIGHT);
-		snprintf(text, sizeof(text), "%s", module->rootName.c_str());
-		nvgText(ctx.vg, box.size.x - 5, box.pos.y, text, NULL);
+	void updateNames(GalaxyChordState &chord) {
 
-		snprintf(text, sizeof(text), "%s", module->modeName.c_str());
-		nvgText(ctx.vg, box.size.x - 5, box.pos.y + 11, text, NULL);
+		if (chord.chord < 0) {
+			chordName = "";
+			chordExtName = "";
+			return;
+		}
+
+		music::InversionDefinition &invDef = module->knownChords.chords[chord.chord].inversions[chord.inversion];
+
+		if (chord.modeDegree != -1) {
+			chordName = invDef.getName(chord.mode, chord.key, chord.modeDegree, chord.rootNote);
+			chordExtName = module->degNames[chord.modeDegree * 6 + chord.quality];
+		} else {
+			chordName = invDef.getName(chord.rootNote);
+			chordExtName = "";
+		}
 
 	}
 
 };
 
+static void loadTransitions(Galaxy *module) {
+	char *path = osdialog_file(OSDIALOG_OPEN, asset::user("").c_str(), "transitions.json", NULL);
+	if (path) {
+		music::DegreeTransitions t;
+		if (t.load(path)) {
+			module->setTransitions(t);
+		}
+		free(path);
+	}
+}
+
 struct GalaxyWidget : ModuleWidget {
 
 	GalaxyWidget(Galaxy *module)  {
@@ -467,7 +739,7 @@ struct GalaxyWidget : ModuleWidget {
 			GalaxyDisplay *displayW = createWidget<GalaxyDisplay>(Vec(0, 20));
 			displayW->box.size = Vec(240, 230);
 			displayW->module = module;
-			addChild(displayW);
+			addChild(new gui::DisplayCache(displayW));
 		}
 
 	}
@@ -501,6 +773,20 @@ struct GalaxyWidget : ModuleWidget {
 			}
 		};
 
+		struct TransitionsItem : MenuItem {
+			Galaxy *module;
+			void onAction(const rack::event::Action &e) override {
+				loadTransitions(module);
+			}
+		};
+
+		struct ResetTransitionsItem : MenuItem {
+			Galaxy *module;
+			void onAction(const rack::event::Action &e) override {
+				module->resetTransitions();
+			}
+		};
+
 		struct OffsetMenu : MenuItem {
 			Galaxy *module;
 			Menu *createChildMenu() override {
@@ -562,6 +848,23 @@ struct GalaxyWidget : ModuleWidget {
 		invItem->module = galaxy;
 		menu->addChild(invItem);
 
+		TransitionsItem *transItem = createMenuItem<TransitionsItem>("Load transition matrix", CHECKMARK(galaxy->customTransitions));
+		transItem->module = galaxy;
+		menu->addChild(transItem);
+
+		ResetTransitionsItem *resetTransItem = createMenuItem<ResetTransitionsItem>("Reset transition matrix");
+		resetTransItem->module = galaxy;
+		menu->addChild(resetTransItem);
+
+		gui::SeedMenu *seedItem = createMenuItem<gui::SeedMenu>("Random seed");
+		seedItem->rng = &(galaxy->rng);
+		seedItem->request = &(galaxy->seedRequest);
+		menu->addChild(seedItem);
+
+		gui::ProcessTimeItem *timeItem = createMenuItem<gui::ProcessTimeItem>("Max process time");
+		timeItem->module = galaxy;
+		menu->addChild(timeItem);
+
 	}
 
 };
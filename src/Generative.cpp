@@ -141,6 +141,8 @@ struct Generative : core::AHModule {
 
 		configParam(ATTN_PARAM, 0.0, 1.0, 1.0, "Level", "%", 0.0f, 100.0f);
 
+		music::scaleRegistry.load();
+
 	}
 
 	void process(const ProcessArgs &args) override;
@@ -156,6 +158,16 @@ struct Generative : core::AHModule {
 		json_t *offsetJ = json_boolean(offset);
 		json_object_set_new(rootJ, "offset", offsetJ);
 
+		// user scale
+		if (userScalePending) {
+			json_object_set_new(rootJ, "userScale", json_string(userScaleName.c_str()));
+		} else if (userScale >= 0) {
+			json_object_set_new(rootJ, "userScale", json_string(music::scaleRegistry.get(userScale).name.c_str()));
+		}
+
+		// random
+		json_object_set_new(rootJ, "random", rng.toJson());
+
 		return rootJ;
 	}
 
@@ -174,8 +186,25 @@ struct Generative : core::AHModule {
 			offset = json_boolean_value(offsetJ);
 		}
 
+		// user scale
+		json_t *userScaleJ = json_object_get(rootJ, "userScale");
+		if (json_is_string(userScaleJ)) {
+			userScaleName = json_string_value(userScaleJ);
+			userScale = -1;
+			userScalePending = true;
+		}
+
+		// random
+		json_t *randomJ = json_object_get(rootJ, "random");
+		if (randomJ) {
+			rng.fromJson(randomJ);
+		}
+
 	}
 
+	digital::Random rng;
+	digital::SeedRequest seedRequest;
+
 	rack::dsp::SchmittTrigger sampleTrigger;
 	rack::dsp::SchmittTrigger holdTrigger;
 	rack::dsp::SchmittTrigger clockTrigger;
@@ -188,6 +217,9 @@ struct Generative : core::AHModule {
 	float target = 0.0f;
 	float current = 0.0f;
 	bool quantise = false;
+	int userScale = -1; // Index into music::scaleRegistry, chromatic if none
+	std::string userScaleName; // Saved scale, looked up once the registry has finished loading
+	std::atomic<bool> userScalePending {false};
 	bool offset = false;
 	bool delayState = false;
 	bool gateState = false;
@@ -209,6 +241,8 @@ void Generative::process(const ProcessArgs &args) {
 
 	AHModule::step();
 
+	seedRequest.apply(rng);
+
 	oscillator.setPitch(params[FREQ_PARAM].getValue() + params[FM_PARAM].getValue() * inputs[FM_INPUT].getVoltage());
 	oscillator.offset = offset;
 	oscillator.step(args.sampleTime);
@@ -277,7 +311,7 @@ void Generative::process(const ProcessArgs &args) {
 
 			// Check against prob control
 			float threshold = clamp(params[PROB_PARAM].getValue() + inputs[PROB_INPUT].getVoltage() / 10.f, 0.f, 1.f);
-			toss = (random::uniform() < threshold);
+			toss = (rng.uniform() < threshold);
 
 			// Tick is valid
 			if (toss) {
@@ -286,7 +320,7 @@ void Generative::process(const ProcessArgs &args) {
 				float dlyLen = log2(params[DELAYL_PARAM].getValue());
 				float dlySpr = log2(params[DELAYS_PARAM].getValue());
 
-				double rndD = clamp(random::normal(), -2.0f, 2.0f);
+				double rndD = digital::clampedNormal(rng);
 				delayTime = clamp(dlyLen + dlySpr * rndD, 0.0f, 100.0f);
 				
 				// Trigger the respective delay pulse generator
@@ -306,7 +340,7 @@ void Generative::process(const ProcessArgs &args) {
 		float gateLen = log2(params[GATEL_PARAM].getValue());
 		float gateSpr = log2(params[GATES_PARAM].getValue());
 
-		double rndG = clamp(random::normal(), -2.0f, 2.0f);
+		double rndG = digital::clampedNormal(rng);
 		gateTime = clamp(gateLen + gateSpr * rndG, digital::TRIGGER, 100.0f);
 
 		// Open the gate and set flags
@@ -339,7 +373,15 @@ void Generative::process(const ProcessArgs &args) {
 
 	// Quantise or not
 	float out;
-	if (quantise) {
+	if (userScalePending && music::scaleRegistry.isLoaded()) {
+		userScale = music::scaleRegistry.find(userScaleName);
+		userScalePending = false;
+	}
+
+	int scale = userScale;
+	if (quantise && scale >= 0) {
+		out = music::scaleRegistry.get(scale).quantise(current, music::NOTE_C);
+	} else if (quantise) {
 		out = music::getPitchFromVolts(current, music::NOTE_C, music::SCALE_CHROMATIC);
 	} else {
 		out = current;
@@ -447,6 +489,10 @@ struct GenerativeWidget : ModuleWidget {
 			menu->addChild(construct<MenuLabel>());
 			menu->addChild(construct<GenModeItem>(&MenuItem::text, "Quantise", &GenModeItem::gen, gen));
 			menu->addChild(construct<GenOffsetItem>(&MenuItem::text, "CV Offset", &GenOffsetItem::gen, gen));
+			menu->addChild(construct<gui::UserScaleMenu>(&MenuItem::text, "Quantise scale", &gui::UserScaleMenu::userScale, &(gen->userScale), 
+				&gui::UserScaleMenu::noneName, std::string("Chromatic")));
+			menu->addChild(construct<gui::SeedMenu>(&MenuItem::text, "Random seed", &gui::SeedMenu::rng, &(gen->rng), 
+				&gui::SeedMenu::request, &(gen->seedRequest)));
 	}
 };
 
@@ -58,6 +58,9 @@ struct Imp : core::AHModule {
 		json_t *randomZeroJ = json_boolean(randomZero);
 		json_object_set_new(rootJ, "randomzero", randomZeroJ);
 
+		// random
+		json_object_set_new(rootJ, "random", rng.toJson());
+
 		return rootJ;
 	}
 
@@ -68,24 +71,37 @@ struct Imp : core::AHModule {
 		if (randomZeroJ)
 			randomZero = json_boolean_value(randomZeroJ);
 
+		// random
+		json_t *randomJ = json_object_get(rootJ, "random");
+		if (randomJ)
+			rng.fromJson(randomJ);
+
 	}
 
 	void process(const ProcessArgs &args) override;
 
+	void processEvents();
+
 	void onReset() override {
-		coreDelayState = false;
-		coreGateState = false;
 		coreDelayTime = 0.0;
 		coreGateTime = 0.0;
 		for (int i = 0; i < 16; i++) {
-			delayState[i] = false;
-			gateState[i] = false;
 			delayTime[i] = 0.0;
 			gateTime[i] = 0.0;
+			outputs[OUT_OUTPUT].setVoltage(0.0f, i);
 		}
+		for (int i = 0; i < NUM_GENERATORS; i++) {
+			phase[i] = IDLE;
+		}
+		schedule.reset();
 		bpm = 0.0;
 	}
 
+	// Sample count of a time in seconds, at least 1 so that every phase lasts at least one sample
+	int64_t toSamples(float seconds) {
+		return std::max((int64_t)1, (int64_t)std::ceil(seconds * sampleRate));
+	}
+
 	int delayTimeMs;
 	int delaySprMs;
 	int gateTimeMs;
@@ -96,19 +112,23 @@ struct Imp : core::AHModule {
 	int actGateMs = 0;
 	float prob;
 
-	bool coreDelayState;
-	bool coreGateState;
 	float coreDelayTime;
 	float coreGateTime;
-	digital::AHPulseGenerator coreDelayPhase;
-	digital::AHPulseGenerator coreGatePhase;
-
-	bool delayState[16];
-	bool gateState[16];
 	float delayTime[16];
 	float gateTime[16];
-	digital::AHPulseGenerator delayPhase[16];
-	digital::AHPulseGenerator gatePhase[16];
+
+	// Each output, and the unrandomised core generator that drives the light, steps through a delay and a gate.
+	// Transitions are scheduled in samples, so there is no work to do between them
+	const static int CORE = 16;
+	const static int NUM_GENERATORS = 17;
+	enum Phase {
+		IDLE,
+		DELAY,
+		GATE
+	};
+	Phase phase[NUM_GENERATORS];
+	digital::TimerSchedule<NUM_GENERATORS> schedule;
+	float sampleRate = 44100.0f;
 
 	rack::dsp::SchmittTrigger inTrigger;
 
@@ -117,12 +137,20 @@ struct Imp : core::AHModule {
 
 	digital::BpmCalculator bpmCalc;
 
+	digital::Random rng;
+	digital::SeedRequest seedRequest;
+
 };
 
 void Imp::process(const ProcessArgs &args) {
 
 	AHModule::step();
 
+	seedRequest.apply(rng);
+
+	sampleRate = args.sampleRate;
+	outputs[OUT_OUTPUT].setChannels(16);
+
 	float dlyLen;
 	float dlySpr;
 	float gateLen;
@@ -164,10 +192,10 @@ void Imp::process(const ProcessArgs &args) {
 		}
 
 		// Check clock division and Bern. gate
-		if ((counter % division == 0) && (random::uniform() < params[PROB_PARAM].getValue())) { 
+		if ((counter % division == 0) && (rng.uniform() < params[PROB_PARAM].getValue())) { 
 
 			// check that we are not in the gate phase
-			if (!coreGatePhase.ishigh() && !coreDelayPhase.ishigh()) {
+			if (phase[CORE] == IDLE) {
 
 				// Determine delay and gate times for all active outputs
 				coreDelayTime = clamp(dlyLen, 0.0f, 100.0f);
@@ -176,21 +204,24 @@ void Imp::process(const ProcessArgs &args) {
 				coreGateTime = clamp(gateLen, digital::TRIGGER, 100.0f);
 
 				if (debugEnabled()) { 
-					std::cout << stepX << " Delay: " << ": Len = " << delayTime << std::endl; 
-					std::cout << stepX << " Gate: " << ": Len = " << gateTime << std::endl; 
+					std::cout << stepX << " Delay: " << ": Len = " << coreDelayTime << std::endl; 
+					std::cout << stepX << " Gate: " << ": Len = " << coreGateTime << std::endl; 
 				}
 
-				// Trigger the respective delay pulse generator
-				coreDelayState = true;
-				if (coreDelayPhase.trigger(coreDelayTime)) {
-					actDelayMs = coreDelayTime * 1000;
-				}
+				// Start the delay
+				phase[CORE] = DELAY;
+				schedule.schedule(CORE, toSamples(coreDelayTime) - 1);
+				actDelayMs = coreDelayTime * 1000;
 			}
 
+			// Delay and gate spreads for all outputs in one go
+			float rnd[32];
+			digital::clampedNormals(rng, rnd, 32);
+
 			for (int i = 0; i < 16; i++) {
 
 				// check that we are not in the gate phase
-				if (!gatePhase[i].ishigh() && !delayPhase[i].ishigh()) {
+				if (phase[i] == IDLE) {
 
 					if (i == 0 && !randomZero) {
 
@@ -199,77 +230,92 @@ void Imp::process(const ProcessArgs &args) {
 						gateTime[i] = coreGateTime;
 
 						if (debugEnabled()) { 
-							std::cout << stepX << " Delay: " << ": Len: " << dlyLen << " Spr: " << dlySpr << " = " << delayTime << std::endl; 
-							std::cout << stepX << " Gate: " << ": Len: " << gateLen << ", Spr: " << gateSpr << " = " << gateTime << std::endl; 
+							std::cout << stepX << " Delay: " << ": Len: " << dlyLen << " Spr: " << dlySpr << " = " << delayTime[i] << std::endl; 
+							std::cout << stepX << " Gate: " << ": Len: " << gateLen << ", Spr: " << gateSpr << " = " << gateTime[i] << std::endl; 
 						}
 
 					} else {
 
 						// Determine delay and gate times for all active outputs
-						double rndD = clamp(random::normal(), -2.0f, 2.0f);
+						double rndD = rnd[i * 2];
 						delayTime[i] = clamp(dlyLen + dlySpr * rndD, 0.0f, 100.0f);
 					
 						// The modified gate time cannot be earlier than the start of the delay
-						double rndG = clamp(random::normal(), -2.0f, 2.0f);
+						double rndG = rnd[i * 2 + 1];
 						gateTime[i] = clamp(gateLen + gateSpr * rndG, digital::TRIGGER, 100.0f);
 
 						if (debugEnabled()) { 
-							std::cout << stepX << " Delay: " << ": Len: " << dlyLen << " Spr: " << dlySpr << " r: " << rndD << " = " << delayTime << std::endl; 
-							std::cout << stepX << " Gate: " << ": Len: " << gateLen << ", Spr: " << gateSpr << " r: " << rndG << " = " << gateTime << std::endl; 
+							std::cout << stepX << " Delay: " << ": Len: " << dlyLen << " Spr: " << dlySpr << " r: " << rndD << " = " << delayTime[i] << std::endl; 
+							std::cout << stepX << " Gate: " << ": Len: " << gateLen << ", Spr: " << gateSpr << " r: " << rndG << " = " << gateTime[i] << std::endl; 
 						}
 
 					}
 
-					// Trigger the respective delay pulse generator
-					delayPhase[i].trigger(delayTime[i]);
-					delayState[i] = true;
+					// Start the delay, the gate opens on the sample it ends
+					phase[i] = DELAY;
+					schedule.schedule(i, toSamples(delayTime[i]) - 1);
 
 				}
 			}
 		}
 	}
 
-	if (coreDelayState && !coreDelayPhase.process(args.sampleTime)) {
-		if (coreGatePhase.trigger(coreGateTime)) {
-			actGateMs = coreGateTime * 1000;
-		}
-		coreGateState = true;
-		coreDelayState = false;
+	if (schedule.pending()) {
+		processEvents();
 	}
+	schedule.tick();
 
-	if (coreGatePhase.process(args.sampleTime)) {
+	if (phase[CORE] == GATE) {
 		lights[OUT_LIGHT].setSmoothBrightness(1.0f, args.sampleTime);
 		lights[OUT_LIGHT + 1].setSmoothBrightness(0.0f, args.sampleTime);
+	} else if (phase[CORE] == DELAY) {
+		lights[OUT_LIGHT].setSmoothBrightness(0.0f, args.sampleTime);
+		lights[OUT_LIGHT + 1].setSmoothBrightness(1.0f, args.sampleTime);
 	} else {
-		coreGateState = false;
-
-		if (coreDelayState) {
-			lights[OUT_LIGHT].setSmoothBrightness(0.0f, args.sampleTime);
-			lights[OUT_LIGHT + 1].setSmoothBrightness(1.0f, args.sampleTime);
-		} else {
-			lights[OUT_LIGHT].setSmoothBrightness(0.0f, args.sampleTime);
-			lights[OUT_LIGHT + 1].setSmoothBrightness(0.0f, args.sampleTime);
-		}
+		lights[OUT_LIGHT].setSmoothBrightness(0.0f, args.sampleTime);
+		lights[OUT_LIGHT + 1].setSmoothBrightness(0.0f, args.sampleTime);
 	}
 
-	outputs[OUT_OUTPUT].setChannels(16);
-	for (int i = 0; i < 16; i++) {
-		if (delayState[i] && !delayPhase[i].process(args.sampleTime)) {
-			gatePhase[i].trigger(gateTime[i]);
-			gateState[i] = true;
-			delayState[i] = false;
+}
+
+void Imp::processEvents() {
+
+	for (int i = 0; i < NUM_GENERATORS; i++) {
+
+		if (!schedule.isDue(i)) {
+			continue;
 		}
 
-		if (gatePhase[i].process(args.sampleTime)) {
-			outputs[OUT_OUTPUT].setVoltage(10.0f, i);
+		if (phase[i] == DELAY) {
+
+			// Delay over, open the gate
+			phase[i] = GATE;
+			if (i == CORE) {
+				schedule.schedule(i, toSamples(coreGateTime) - 1);
+				actGateMs = coreGateTime * 1000;
+			} else {
+				schedule.schedule(i, toSamples(gateTime[i]) - 1);
+				outputs[OUT_OUTPUT].setVoltage(10.0f, i);
+			}
+
 		} else {
-			outputs[OUT_OUTPUT].setVoltage(0.0f, i);
-			gateState[i] = false;
+
+			// Gate over
+			phase[i] = IDLE;
+			schedule.cancel(i);
+			if (i != CORE) {
+				outputs[OUT_OUTPUT].setVoltage(0.0f, i);
+			}
+
 		}
-	}	
+
+	}
+
+	schedule.update();
+
 }
 
-struct ImpBox : TransparentWidget {
+struct ImpBox : gui::SnapshotDisplay {
 	
 	Imp *module;
 	std::shared_ptr<Font> font;
@@ -282,9 +328,51 @@ struct ImpBox : TransparentWidget {
 	int *division;
 	int *actDly;
 	int *actGate;
+
+	// Values as last drawn
+	struct State {
+		float bpm = 0.0f;
+		float prob = 0.0f;
+		int dly = 0;
+		int dlySpr = 0;
+		int gate = 0;
+		int gateSpr = 0;
+		int division = 0;
+		int actDly = 0;
+		int actGate = 0;
+	};
+
+	State state;
 	
 	ImpBox() {
-		font = APP->window->loadFont(asset::plugin(pluginInstance, "res/DSEG14ClassicMini-BoldItalic.ttf"));
+		font = gui::getFont(gui::FONT_DSEG14);
+	}
+
+	bool snapshot() override {
+
+		if (module == NULL) {
+			return false;
+		}
+
+		State s;
+		s.bpm = *bpm;
+		s.prob = *prob;
+		s.dly = *dly;
+		s.dlySpr = *dlySpr;
+		s.gate = *gate;
+		s.gateSpr = *gateSpr;
+		s.division = *division;
+		s.actDly = *actDly;
+		s.actGate = *actGate;
+
+		if (s.bpm == state.bpm && s.prob == state.prob && s.dly == state.dly && s.dlySpr == state.dlySpr && s.gate == state.gate && 
+			s.gateSpr == state.gateSpr && s.division == state.division && s.actDly == state.actDly && s.actGate == state.actGate) {
+			return false;
+		}
+
+		state = s;
+		return true;
+
 	}
 
 	void draw(const DrawArgs &ctx) override {
@@ -293,7 +381,7 @@ struct ImpBox : TransparentWidget {
 			return;
 	    }
 
-		Vec pos(15.0, 0.0);
+		Vec pos(15.0, 47.0);
 
 		float n = 35.0;
 
@@ -304,40 +392,40 @@ struct ImpBox : TransparentWidget {
 		nvgFillColor(ctx.vg, nvgRGBA(0x00, 0xFF, 0xFF, 0xFF));
 	
 		char text[10];
-		if (*bpm == 0.0f) {
+		if (state.bpm == 0.0f) {
 			snprintf(text, sizeof(text), "-");
 		} else {
-			snprintf(text, sizeof(text), "%.1f", *bpm);
+			snprintf(text, sizeof(text), "%.1f", state.bpm);
 		}
 		nvgText(ctx.vg, pos.x + 75, pos.y + -1 * n, text, NULL);
 
-		snprintf(text, sizeof(text), "%.1f", *prob);
+		snprintf(text, sizeof(text), "%.1f", state.prob);
 		nvgText(ctx.vg, pos.x + 75, pos.y, text, NULL);
 
-		snprintf(text, sizeof(text), "%d", *dly);
+		snprintf(text, sizeof(text), "%d", state.dly);
 		nvgText(ctx.vg, pos.x + 75, pos.y + 1 * n, text, NULL);
 
-		if (*dlySpr != 0) {
-			snprintf(text, sizeof(text), "%d", *dlySpr);
+		if (state.dlySpr != 0) {
+			snprintf(text, sizeof(text), "%d", state.dlySpr);
 			nvgText(ctx.vg, pos.x + 75, pos.y + 2 * n, text, NULL);
 		}
 
-		snprintf(text, sizeof(text), "%d", *gate);
+		snprintf(text, sizeof(text), "%d", state.gate);
 		nvgText(ctx.vg, pos.x + 75, pos.y + 3 * n, text, NULL);
 
-		if (*gateSpr != 0) {
-			snprintf(text, sizeof(text), "%d", *gateSpr);
+		if (state.gateSpr != 0) {
+			snprintf(text, sizeof(text), "%d", state.gateSpr);
 			nvgText(ctx.vg, pos.x + 75, pos.y + 4 * n, text, NULL);
 		}
 
-		snprintf(text, sizeof(text), "%d", *division);
+		snprintf(text, sizeof(text), "%d", state.division);
 		nvgText(ctx.vg, pos.x + 75, pos.y + 5 * n, text, NULL);
 		
-		snprintf(text, sizeof(text), "%d", *actGate);
+		snprintf(text, sizeof(text), "%d", state.actGate);
 		nvgText(ctx.vg, pos.x + 75, pos.y + 6 * n, text, NULL);
 
 		nvgTextAlign(ctx.vg, NVGalign::NVG_ALIGN_RIGHT);
-		snprintf(text, sizeof(text), "%d", *actDly);
+		snprintf(text, sizeof(text), "%d", state.actDly);
 		nvgText(ctx.vg, pos.x + 27.5, pos.y + 6 * n, text, NULL);
 
 	}
@@ -362,10 +450,10 @@ struct ImpWidget : ModuleWidget {
 		addOutput(createOutput<PJ301MPort>(gui::getPosition(gui::PORT, 1, 8, true, true), module, Imp::OUT_OUTPUT));
 
 		if (module != NULL) {
-			ImpBox *display = createWidget<ImpBox>(Vec(0, 82));
+			ImpBox *display = createWidget<ImpBox>(Vec(0, 35));
 
 			display->module = module;
-			display->box.size = Vec(20, 200);
+			display->box.size = Vec(135, 265);
 
 			display->bpm = &(module->bpm);
 			display->prob = &(module->prob);
@@ -377,7 +465,7 @@ struct ImpWidget : ModuleWidget {
 			display->actDly = &(module->actDelayMs);
 			display->actGate = &(module->actGateMs);
 
-			addChild(display);
+			addChild(new gui::DisplayCache(display));
 		}	
 	}
 
@@ -415,6 +503,11 @@ struct ImpWidget : ModuleWidget {
 		randomZeroItem->module = imp;
 		menu->addChild(randomZeroItem);
 
+		gui::SeedMenu *seedItem = createMenuItem<gui::SeedMenu>("Random seed");
+		seedItem->rng = &(imp->rng);
+		seedItem->request = &(imp->seedRequest);
+		menu->addChild(seedItem);
+
 	}
 
 };
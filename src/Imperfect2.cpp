@@ -55,6 +55,24 @@ struct Imperfect2 : core::AHModule {
 
 	void process(const ProcessArgs &args) override;
 
+	json_t *dataToJson() override {
+		json_t *rootJ = json_object();
+
+		// random
+		json_object_set_new(rootJ, "random", rng.toJson());
+
+		return rootJ;
+	}
+
+	void dataFromJson(json_t *rootJ) override {
+
+		// random
+		json_t *randomJ = json_object_get(rootJ, "random");
+		if (randomJ)
+			rng.fromJson(randomJ);
+
+	}
+
 	void onReset() override {
 		for (int i = 0; i < 4; i++) {
 			delayState[i] = false;
@@ -78,20 +96,25 @@ struct Imperfect2 : core::AHModule {
 	int actDelayMs[4] = {0, 0, 0, 0};
 	int actGateMs[4] = {0, 0, 0, 0};
 
-	digital::AHPulseGenerator delayPhase[4];
-	digital::AHPulseGenerator gatePhase[4];
-	rack::dsp::SchmittTrigger inTrigger[4];
+	digital::PulseBank<4> delayPhase;
+	digital::PulseBank<4> gatePhase;
+	digital::TriggerBank<4> inTrigger;
 
 	int counter[4];
 
 	digital::BpmCalculator bpmCalc[4];
 
+	digital::Random rng;
+	digital::SeedRequest seedRequest;
+
 };
 
 void Imperfect2::process(const ProcessArgs &args) {
 
 	AHModule::step();
 
+	seedRequest.apply(rng);
+
 	float dlyLen;
 	float dlySpr;
 	float gateLen;
@@ -99,12 +122,18 @@ void Imperfect2::process(const ProcessArgs &args) {
 
 	int lastValidInput = -1;
 
+	float trigIn[4];
+	for (int i = 0; i < 4; i++) {
+		trigIn[i] = inputs[TRIG_INPUT + i].getVoltage();
+	}
+	uint32_t triggered = inTrigger.process(trigIn);
+
 	for (int i = 0; i < 4; i++) {
 
 		bool generateSignal = false;
 
 		bool inputActive = inputs[TRIG_INPUT + i].isConnected();
-		bool haveTrigger = inTrigger[i].process(inputs[TRIG_INPUT + i].getVoltage());
+		bool haveTrigger = (triggered >> i) & 1;
 		bool outputActive = outputs[OUT_OUTPUT + i].isConnected();
 
 		// This is where we manage row-chaining/normalisation, i.e a row can be active without an
@@ -176,14 +205,14 @@ void Imperfect2::process(const ProcessArgs &args) {
 			if (counter[lastValidInput] % target == 0) { 
 
 				// check that we are not in the gate phase
-				if (!gatePhase[i].ishigh() && !delayPhase[i].ishigh()) {
+				if (!gatePhase.isHigh(i) && !delayPhase.isHigh(i)) {
 
 				// Determine delay and gate times for all active outputs
-					double rndD = clamp(random::normal(), -2.0f, 2.0f);
+					double rndD = digital::clampedNormal(rng);
 					delayTime[i] = clamp(dlyLen + dlySpr * rndD, 0.0f, 100.0f);
 
 					// The modified gate time cannot be earlier than the start of the delay
-					double rndG = clamp(random::normal(), -2.0f, 2.0f);
+					double rndG = digital::clampedNormal(rng);
 					gateTime[i] = clamp(gateLen + gateSpr * rndG, digital::TRIGGER, 100.0f);
 
 					if (debugEnabled()) { 
@@ -193,7 +222,7 @@ void Imperfect2::process(const ProcessArgs &args) {
 
 					// Trigger the respective delay pulse generator
 					delayState[i] = true;
-					if (delayPhase[i].trigger(delayTime[i])) {
+					if (delayPhase.trigger(i, delayTime[i])) {
 						actDelayMs[i] = delayTime[i] * 1000;
 					}
 
@@ -203,17 +232,23 @@ void Imperfect2::process(const ProcessArgs &args) {
 		}
 	}
 
-	for (int i = 0; i < 4; i++) {
+	uint32_t delayHigh = delayPhase.process(args.sampleTime);
 
-		if (delayState[i] && !delayPhase[i].process(args.sampleTime)) {
-			if (gatePhase[i].trigger(gateTime[i])) {
+	for (int i = 0; i < 4; i++) {
+		if (delayState[i] && !((delayHigh >> i) & 1)) {
+			if (gatePhase.trigger(i, gateTime[i])) {
 				actGateMs[i] = gateTime[i] * 1000;
 			}
 			gateState[i] = true;
 			delayState[i] = false;
 		}
+	}
+
+	uint32_t gateHigh = gatePhase.process(args.sampleTime);
+
+	for (int i = 0; i < 4; i++) {
 
-		if (gatePhase[i].process(args.sampleTime)) {
+		if ((gateHigh >> i) & 1) {
 			outputs[OUT_OUTPUT + i].setVoltage(10.0f);
 
 			lights[OUT_LIGHT + i * 2].setSmoothBrightness(1.0f, args.sampleTime);
@@ -237,7 +272,7 @@ void Imperfect2::process(const ProcessArgs &args) {
 
 }
 
-struct Imperfect2Box : TransparentWidget {
+struct Imperfect2Box : gui::SnapshotDisplay {
 
 	Imperfect2 *module;
 	std::shared_ptr<Font> font;
@@ -250,8 +285,48 @@ struct Imperfect2Box : TransparentWidget {
 	int *actDly;
 	int *actGate;
 
+	// Values as last drawn
+	struct State {
+		float bpm = 0.0f;
+		int dly = 0;
+		int dlySpr = 0;
+		int gate = 0;
+		int gateSpr = 0;
+		int division = 0;
+		int actDly = 0;
+		int actGate = 0;
+	};
+
+	State state;
+
 	Imperfect2Box() {
-		font = APP->window->loadFont(asset::plugin(pluginInstance, "res/DSEG14ClassicMini-BoldItalic.ttf"));
+		font = gui::getFont(gui::FONT_DSEG14);
+	}
+
+	bool snapshot() override {
+
+		if (module == NULL) {
+			return false;
+		}
+
+		State s;
+		s.bpm = *bpm;
+		s.dly = *dly;
+		s.dlySpr = *dlySpr;
+		s.gate = *gate;
+		s.gateSpr = *gateSpr;
+		s.division = *division;
+		s.actDly = *actDly;
+		s.actGate = *actGate;
+
+		if (s.bpm == state.bpm && s.dly == state.dly && s.dlySpr == state.dlySpr && s.gate == state.gate && 
+			s.gateSpr == state.gateSpr && s.division == state.division && s.actDly == state.actDly && s.actGate == state.actGate) {
+			return false;
+		}
+
+		state = s;
+		return true;
+
 	}
 
 	void draw(const DrawArgs &ctx) override {
@@ -269,37 +344,37 @@ struct Imperfect2Box : TransparentWidget {
 		nvgFillColor(ctx.vg, nvgRGBA(0x00, 0xFF, 0xFF, 0xFF));
 
 		char text[10];
-		if (*bpm == 0.0f) {
+		if (state.bpm == 0.0f) {
 			snprintf(text, sizeof(text), "-");
 		} else {
-			snprintf(text, sizeof(text), "%.1f", *bpm);
+			snprintf(text, sizeof(text), "%.1f", state.bpm);
 		}
 		nvgText(ctx.vg, pos.x + 20, pos.y, text, NULL);
 
-		snprintf(text, sizeof(text), "%d", *dly);
+		snprintf(text, sizeof(text), "%d", state.dly);
 		nvgText(ctx.vg, pos.x + 74, pos.y, text, NULL);
 
-		if (*dlySpr != 0) {
-			snprintf(text, sizeof(text), "%d", *dlySpr);
+		if (state.dlySpr != 0) {
+			snprintf(text, sizeof(text), "%d", state.dlySpr);
 			nvgText(ctx.vg, pos.x + 144, pos.y, text, NULL);
 		}
 
-		snprintf(text, sizeof(text), "%d", *gate);
+		snprintf(text, sizeof(text), "%d", state.gate);
 		nvgText(ctx.vg, pos.x + 214, pos.y, text, NULL);
 
-		if (*gateSpr != 0) {
-			snprintf(text, sizeof(text), "%d", *gateSpr);
+		if (state.gateSpr != 0) {
+			snprintf(text, sizeof(text), "%d", state.gateSpr);
 			nvgText(ctx.vg, pos.x + 284, pos.y, text, NULL);
 		}
 
-		snprintf(text, sizeof(text), "%d", *division);
+		snprintf(text, sizeof(text), "%d", state.division);
 		nvgText(ctx.vg, pos.x + 334, pos.y, text, NULL);
 
 		nvgFillColor(ctx.vg, nvgRGBA(0, 0, 0, 0xff));
-		snprintf(text, sizeof(text), "%d", *actDly);
+		snprintf(text, sizeof(text), "%d", state.actDly);
 		nvgText(ctx.vg, pos.x + 372, pos.y, text, NULL);
 
-		snprintf(text, sizeof(text), "%d", *actGate);
+		snprintf(text, sizeof(text), "%d", state.actGate);
 		nvgText(ctx.vg, pos.x + 408, pos.y, text, NULL);
 
 	}
@@ -334,7 +409,7 @@ struct Imperfect2Widget : ModuleWidget {
 				Imperfect2Box *display = createWidget<Imperfect2Box>(Vec(10, 95));
 
 				display->module = module;
-				display->box.size = Vec(200, 20);
+				display->box.size = Vec(430, 20);
 
 				display->bpm = &(module->bpm[0]);
 				display->dly = &(module->delayTimeMs[0]);
@@ -345,14 +420,14 @@ struct Imperfect2Widget : ModuleWidget {
 				display->actDly = &(module->actDelayMs[0]);
 				display->actGate = &(module->actGateMs[0]);
 
-				addChild(display);
+				addChild(new gui::DisplayCache(display));
 			}
 
 			{
 				Imperfect2Box *display = createWidget<Imperfect2Box>(Vec(10, 165));
 
 				display->module = module;
-				display->box.size = Vec(200, 20);
+				display->box.size = Vec(430, 20);
 
 				display->bpm = &(module->bpm[1]);
 				display->dly = &(module->delayTimeMs[1]);
@@ -363,14 +438,14 @@ struct Imperfect2Widget : ModuleWidget {
 				display->actDly = &(module->actDelayMs[1]);
 				display->actGate = &(module->actGateMs[1]);
 
-				addChild(display);
+				addChild(new gui::DisplayCache(display));
 			}
 
 			{
 				Imperfect2Box *display = createWidget<Imperfect2Box>(Vec(10, 235));
 
 				display->module = module;
-				display->box.size = Vec(200, 20);
+				display->box.size = Vec(430, 20);
 
 				display->bpm = &(module->bpm[2]);
 				display->dly = &(module->delayTimeMs[2]);
@@ -381,14 +456,14 @@ struct Imperfect2Widget : ModuleWidget {
 				display->actDly = &(module->actDelayMs[2]);
 				display->actGate = &(module->actGateMs[2]);
 
-				addChild(display);
+				addChild(new gui::DisplayCache(display));
 			}
 
 			{
 				Imperfect2Box *display = createWidget<Imperfect2Box>(Vec(10, 305));
 
 				display->module = module;
-				display->box.size = Vec(200, 20);
+				display->box.size = Vec(430, 20);
 
 				display->bpm = &(module->bpm[3]);
 				display->dly = &(module->delayTimeMs[3]);
@@ -399,10 +474,23 @@ struct Imperfect2Widget : ModuleWidget {
 				display->actDly = &(module->actDelayMs[3]);
 				display->actGate = &(module->actGateMs[3]);
 
-				addChild(display);
+				addChild(new gui::DisplayCache(display));
 			}
 		}
 	}
+
+	void appendContextMenu(Menu *menu) override {
+
+		Imperfect2 *imp = dynamic_cast<Imperfect2*>(module);
+		assert(imp);
+
+		menu->addChild(construct<MenuLabel>());
+		gui::SeedMenu *seedItem = createMenuItem<gui::SeedMenu>("Random seed");
+		seedItem->rng = &(imp->rng);
+		seedItem->request = &(imp->seedRequest);
+		menu->addChild(seedItem);
+
+	}
 };
 
 Model *modelImperfect2 = createModel<Imperfect2, Imperfect2Widget>("Imperfect2");
@@ -1,129 +1,20 @@
 #include "AH.hpp"
 #include "AHCommon.hpp"
 
+#include <chrono>
+#include <climits>
 #include <iostream>
 
 using namespace ah;
 
-struct Operator {
-
-	float a;
-	float b;
-	float outV;
-	bool valid = true;
-
-	virtual float asValue() {
-		return outV; 
-	}
-
-	virtual std::string asString() {
-		return std::to_string(outV);
-	}
-
-	virtual bool isValid() {
-		return valid;
-	}
-
-	virtual void addSample(float _a, float _b) {
-		a = _a;
-		b = _b;
-	}
-
-	virtual void reset() {};
-
-	virtual void calculate() = 0;
-
-	virtual ~Operator() = default;
-
-};
-
-struct AddOperator : Operator {
-
-	void calculate() override {
-		outV = a + b;
-		valid = true;
-	}
-
-};
-
-struct SubOperator : Operator {
-
-	void calculate() override {
-		outV = a - b;	
-		valid = true;
-	}
-
-};
-
-struct NoteOperator : Operator {
-
-	int octave = 0;
-	int semitone = 0;
-	int cents = 0;
-
-	std::string asString() override {
-		if (cents == 0) {
-			return music::noteNames[semitone] + std::to_string(octave);
-		} else if (cents < 0) {
-			return music::noteNames[semitone] + std::to_string(octave) + std::to_string(cents);
-		} else {
-			return music::noteNames[semitone] + std::to_string(octave) + "+" + std::to_string(cents);
-		}
-	}
-
-	void calculate() override {
-
-		float v = a + b;
-
-		if (v < -10.0 || v > 10.0) {
-			valid = false;
-			octave = 0;
-			semitone = 0;
-			cents = 0;
-			return;
-		}
-
-		double octV;
-		double octFrac = modf(v, &octV); 
-		octave = (int)octV + 4;
-
-		// Below 0V. modf returns negative o and frac, so actual octave is one lower
-		if (octFrac < 0.0) {
-			octave--;
-			octFrac = octFrac + 1.0;
-		}
-
-		double st;
-		double stFrac = modf(octFrac / music::SEMITONE, &st);
-
-		// semitone 0 - 11 
-		// stFrac is positive fraction of semitone 0 - 1
-		if (stFrac < 0.5) {
-			cents = (int)round(stFrac * 100.0);
-			semitone = (int)st;
-		} else {
-			cents = (int)round((stFrac - 1.0) * 100.0);
-			semitone = (int)st + 1;
-			if (semitone == 12) {
-				octave++;
-				semitone = 0;
-			}
-		}
-
-		outV = (octave - 4) + semitone * music::SEMITONE;
-
-		valid = true;
-
-	}
-
-};
-
 struct PolyProbe : core::AHModule {
 
 	enum Algorithms {
 		SUM,
 		DIFF,
-		NOTE
+		NOTE,
+		CHORD,
+		STATS
 	};
 
 	enum ParamIds {
@@ -142,8 +33,9 @@ struct PolyProbe : core::AHModule {
 		NUM_LIGHTS
 	};
 
-	Operator * oper[3][16];
 	Algorithms currAlgo = SUM;
+	int displayRate = 15; // Display updates per second
+	float statsWindow = 1.0f; // Seconds
 
 	int nChannels = 0;
 	int nCVAChannels = 0;
@@ -152,24 +44,30 @@ struct PolyProbe : core::AHModule {
 
 	bool hasCVAIn = false;
 	bool hasCVBIn = false;
-	float cvA[16];
-	float cvB[16];
-
-	PolyProbe() : core::AHModule(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS) {
-		for (int i = 0; i < 16; i++) {
-			oper[0][i] = new AddOperator;
-			oper[1][i] = new SubOperator;
-			oper[2][i] = new NoteOperator;
-		}
-	}
-
-	~PolyProbe() {
-		for (int i = 0; i < 16; i++) {
-			delete oper[0][i];
-			delete oper[1][i];
-			delete oper[2][i];
-		}
-	}
+	float cvA[16] = {};
+	float cvB[16] = {};
+
+	// Results of the current algorithm per channel, formatted by the display
+	float result[16] = {};
+	float pitch[16] = {}; // NOTE: nearest semitone relative to C4, CHORD: interval above the root
+	float cents[16] = {}; // NOTE only
+	uint32_t valid = 0; // Bitmask of channels with a result
+
+	// Chord(A), only looked up again when the notes change
+	music::PitchClassSet chordNotes;
+	int chordBass = 0;
+	int chord = -1;
+	int chordRoot = 0;
+	int chordInversion = 0;
+
+	// Stats(A), restarted when the window or sample rate changes or the algorithm is selected
+	digital::WindowStats<16> stats;
+	float statsWindowSet = 0.0f;
+	float statsSampleRate = 0.0f;
+	Algorithms lastAlgo = SUM;
+	bool resetPeaks = false;
+
+	PolyProbe() : core::AHModule(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS) {}
 
 	json_t *dataToJson() override {
 		json_t *rootJ = json_object();
@@ -178,6 +76,14 @@ struct PolyProbe : core::AHModule {
 		json_t *algoJ = json_integer((int) currAlgo);
 		json_object_set_new(rootJ, "algo", algoJ);
 
+		// displayRate
+		json_t *rateJ = json_integer(displayRate);
+		json_object_set_new(rootJ, "displayRate", rateJ);
+
+		// statsWindow
+		json_t *windowJ = json_real(statsWindow);
+		json_object_set_new(rootJ, "statsWindow", windowJ);
+
 		return rootJ;
 	}
 
@@ -188,6 +94,16 @@ struct PolyProbe : core::AHModule {
 		if (algoJ)
 			currAlgo = (Algorithms)json_integer_value(algoJ);
 
+		// displayRate
+		json_t *rateJ = json_object_get(rootJ, "displayRate");
+		if (rateJ)
+			displayRate = clamp((int)json_integer_value(rateJ), 1, 60);
+
+		// statsWindow
+		json_t *windowJ = json_object_get(rootJ, "statsWindow");
+		if (windowJ)
+			statsWindow = clamp((float)json_number_value(windowJ), 0.01f, 10.0f);
+
 	}
 
 	void process(const ProcessArgs &args) override {
@@ -212,92 +128,355 @@ struct PolyProbe : core::AHModule {
 
 		nChannels = std::max(nCVAChannels,nCVBChannels);
 
+		// Whole ports at a time, channels beyond nChannels are computed but never shown or output
+		const float *inA = inputs[POLYCVA_INPUT].getVoltages();
+		const float *inB = inputs[POLYCVB_INPUT].getVoltages();
+		for (int k = 0; k < 16; k += 4) {
+			simd::float_4::load(inA + k).store(cvA + k);
+			simd::float_4::load(inB + k).store(cvB + k);
+		}
+
+		switch (currAlgo) {
+			case SUM:	processSum(); break;
+			case DIFF:	processDiff(); break;
+			case NOTE:	processNote(); break;
+			case CHORD:	processChord(); break;
+			case STATS:	processStats(args.sampleRate); break;
+			default:	valid = 0;
+		}
+		lastAlgo = currAlgo;
+		valid &= (1 << nChannels) - 1;
+
 		outputs[POLYALGO_OUTPUT].setChannels(nChannels);
-		for (int i = 0; i < nChannels; i++) {
-			cvA[i] = inputs[POLYCVA_INPUT].getVoltage(i);
-			cvB[i] = inputs[POLYCVB_INPUT].getVoltage(i);
+		float *out = outputs[POLYALGO_OUTPUT].getVoltages();
+		for (int k = 0; k < 16; k += 4) {
+			simd::float_4::load(result + k).store(out + k);
+		}
+
+	}
+
+	void processSum() {
+		for (int k = 0; k < 16; k += 4) {
+			(simd::float_4::load(cvA + k) + simd::float_4::load(cvB + k)).store(result + k);
+		}
+		valid = 0xFFFF;
+	}
+
+	void processDiff() {
+		for (int k = 0; k < 16; k += 4) {
+			(simd::float_4::load(cvA + k) - simd::float_4::load(cvB + k)).store(result + k);
+		}
+		valid = 0xFFFF;
+	}
+
+	// Nearest note to A+B and its offset in cents, rounding half a semitone up
+	void processNote() {
+		valid = 0;
+		for (int k = 0; k < 16; k += 4) {
+			simd::float_4 v = simd::float_4::load(cvA + k) + simd::float_4::load(cvB + k);
+			simd::float_4 inRange = (v >= -10.0f) & (v <= 10.0f);
+			simd::float_4 semitones = v * 12.0f;
+			simd::float_4 nearest = simd::floor(semitones + 0.5f);
+			simd::float_4 offset = simd::floor((semitones - nearest) * 100.0f + 0.5f);
+
+			simd::ifelse(inRange, nearest * music::SEMITONE, 0.0f).store(result + k);
+			simd::ifelse(inRange, nearest, 0.0f).store(pitch + k);
+			simd::ifelse(inRange, offset, 0.0f).store(cents + k);
+			valid |= (uint32_t)simd::movemask(inRange) << k;
+		}
+	}
 
-			oper[currAlgo][i]->addSample(cvA[i], cvB[i]);
-			oper[currAlgo][i]->calculate();
+	// Interval of each channel of A above the root of the chord they form, the output is the root
+	void processChord() {
+		float rootV = recogniseChord();
+		for (int k = 0; k < 16; k += 4) {
+			simd::float_4 steps = simd::floor((simd::float_4::load(cvA + k) - rootV) * 12.0f + 0.5f);
+			(steps - simd::floor(steps / 12.0f) * 12.0f).store(pitch + k);
+			simd::float_4(rootV).store(result + k);
+		}
+		valid = (chord >= 0) ? (1 << nCVAChannels) - 1 : 0;
+	}
 
-			outputs[POLYALGO_OUTPUT].setVoltage(oper[currAlgo][i]->asValue(), i);
+	// Windowed statistics of each channel of A, the output is the mean
+	void processStats(float sampleRate) {
+		if (lastAlgo != STATS || statsWindow != statsWindowSet || sampleRate != statsSampleRate) {
+			statsWindowSet = statsWindow;
+			statsSampleRate = sampleRate;
+			stats.setWindow(statsWindow, sampleRate);
+		}
+		if (resetPeaks) {
+			resetPeaks = false;
+			stats.resetPeak();
+		}
+		stats.process(cvA);
+		for (int k = 0; k < 16; k += 4) {
+			simd::float_4::load(stats.mean + k).store(result + k);
 		}
+		valid = (1 << nCVAChannels) - 1;
+	}
+
+	// Names the chord formed by the active channels of A, returns the voltage of its root below the bass
+	float recogniseChord() {
 
-		for (int i = nChannels; i < 16; i++) {
-			oper[currAlgo][i]->valid = false;
+		int mask = 0;
+		int bass = INT_MAX;
+		for (int i = 0; i < nCVAChannels; i++) {
+			int semi = (int)std::round(cvA[i] * 12.0f);
+			mask |= 1 << eucMod(semi, 12);
+			bass = std::min(bass, semi);
 		}
 
+		music::PitchClassSet notes(mask);
+		int bassClass = (nCVAChannels > 0) ? eucMod(bass, 12) : 0;
+		if (notes != chordNotes || bassClass != chordBass) {
+			chordNotes = notes;
+			chordBass = bassClass;
+			if (nCVAChannels > 0) {
+				const music::ChordIndex::Entry &entry = music::chordIndex.find(notes, bassClass);
+				chord = entry.chord;
+				chordRoot = eucMod(bassClass + entry.root, 12);
+				chordInversion = entry.inversion;
+			} else {
+				chord = -1;
+			}
+		}
+
+		if (chord < 0) {
+			return 0.0f;
+		}
+
+		int rootSemi = bass + eucMod(chordRoot - chordBass, 12);
+		if (rootSemi > bass) {
+			rootSemi -= 12;
+		}
+		return rootSemi * music::SEMITONE;
+
 	}
+
 };
 
 struct PolyProbeDisplay : TransparentWidget {
 
+	// Formatted text, only rewritten when the key of the value it shows changes
+	struct Cell {
+		char text[32];
+		int64_t key = INT64_MIN;
+		bool active = false;
+	};
+
+	// Keys of values that display as "--"
+	static const int64_t INACTIVE = INT64_MIN + 1;
+
 	PolyProbe *module;
 	std::shared_ptr<Font> font;
-	int refresh = 0;
+
+	Cell header[3]; // CV A, CV B, chord name
+	Cell cells[3][16]; // CV A, CV B, result
+	Cell statCells[5][16]; // Min, max, mean, RMS, peak of A
+	int lastAlgo = -1;
+	std::chrono::steady_clock::time_point lastRefresh;
 
 	PolyProbeDisplay() {
-		font = APP->window->loadFont(asset::plugin(pluginInstance, "res/EurostileBold.ttf"));
+		font = gui::getFont(gui::FONT_EUROSTILE);
 	}
 
-	void draw(const DrawArgs &ctx) override {
+	// Values are keyed to the precision of %f
+	static int64_t voltsKey(float v) {
+		return (int64_t)std::llround(v * 1e6);
+	}
 
-		nvgFontSize(ctx.vg, 14);
-		nvgFontFaceId(ctx.vg, font->handle);
-		nvgTextLetterSpacing(ctx.vg, -1);
+	// and statistics to the precision of %.2f
+	static int64_t statKey(float v) {
+		return (int64_t)std::llround(v * 1e2);
+	}
 
-		char text[128];
+	// True if the cell needs formatting for the key
+	static bool update(Cell &cell, int64_t key, bool active) {
+		if (cell.key == key && cell.active == active) {
+			return false;
+		}
+		cell.key = key;
+		cell.active = active;
+		return true;
+	}
 
-		int j = 0;
+	int64_t resultKey(int i) {
+		switch (module->currAlgo) {
+			case PolyProbe::NOTE:	return (int64_t)module->pitch[i] * 1000 + (int64_t)module->cents[i];
+			case PolyProbe::CHORD:	return (int64_t)module->pitch[i];
+			default:				return voltsKey(module->result[i]);
+		}
+	}
 
-		nvgTextAlign(ctx.vg, NVG_ALIGN_LEFT);
-		if (module->hasCVAIn) {
-			nvgFillColor(ctx.vg, nvgRGBA(0x00, 0xFF, 0xFF, 0xFF));
-			snprintf(text, sizeof(text), "CV A In: %d", module->nCVAChannels);
-		} else {
-			nvgFillColor(ctx.vg, nvgRGBA(0x00, 0xFF, 0xFF, 0x6F));
-			snprintf(text, sizeof(text), "No CV A in");
+	void formatResult(int i, char *text, size_t size) {
+		switch (module->currAlgo) {
+			case PolyProbe::NOTE: {
+				int p = (int)module->pitch[i];
+				int c = (int)module->cents[i];
+				const char *name = music::noteNames[eucMod(p, 12)].c_str();
+				int octave = (p - eucMod(p, 12)) / 12 + 4;
+				if (c == 0) {
+					snprintf(text, size, "%s%d", name, octave);
+				} else {
+					snprintf(text, size, "%s%d%+d", name, octave, c);
+				}
+				break;
+			}
+			case PolyProbe::CHORD:
+				snprintf(text, size, "%s", music::intervalNames[eucMod((int)module->pitch[i], 12)].c_str());
+				break;
+			default:
+				snprintf(text, size, "%f", module->result[i]);
 		}
-		nvgText(ctx.vg, box.pos.x + 5, box.pos.y + j * 16, text, NULL);
-		j++;
+	}
 
-		if (module->hasCVBIn) {
-			nvgFillColor(ctx.vg, nvgRGBA(0x00, 0xFF, 0xFF, 0xFF));
-			snprintf(text, sizeof(text), "CV B in: %d", module->nCVBChannels);
-		} else {
-			nvgFillColor(ctx.vg, nvgRGBA(0x00, 0xFF, 0xFF, 0x6F));
-			snprintf(text, sizeof(text), "No CV B in");
+	void refresh() {
+
+		if (module->currAlgo != lastAlgo) {
+			lastAlgo = module->currAlgo;
+			header[2].key = INT64_MIN;
+			for (int i = 0; i < 16; i++) {
+				cells[2][i].key = INT64_MIN;
+			}
 		}
-		nvgText(ctx.vg, box.pos.x + 5, box.pos.y + j * 16, text, NULL);
-		j = j + 2;
 
-		for (int i = 0; i < 16; i++)  {
-			if (i >= module->nCVAChannels) {
-				nvgFillColor(ctx.vg, nvgRGBA(0x00, 0xFF, 0xFF, 0x6F));
-				snprintf(text, sizeof(text), "%02d --", i + 1);
+		Cell &cellA = header[0];
+		if (update(cellA, module->nCVAChannels, module->hasCVAIn)) {
+			if (cellA.active) {
+				snprintf(cellA.text, sizeof(cellA.text), "CV A In: %d", module->nCVAChannels);
 			} else {
-				nvgFillColor(ctx.vg, nvgRGBA(0x00, 0xFF, 0xFF, 0xFF));
-				snprintf(text, sizeof(text), "%02d %f", i + 1, module->cvA[i]);
+				snprintf(cellA.text, sizeof(cellA.text), "No CV A in");
 			}
-			nvgText(ctx.vg, box.pos.x + 5, box.pos.y + i * 16 + j * 16, text, NULL);		
+		}
 
-			if (i >= module->nCVBChannels) {
-				nvgFillColor(ctx.vg, nvgRGBA(0x00, 0xFF, 0xFF, 0x6F));
-				snprintf(text, sizeof(text), "%02d --", i + 1);
+		Cell &cellB = header[1];
+		if (update(cellB, module->nCVBChannels, module->hasCVBIn)) {
+			if (cellB.active) {
+				snprintf(cellB.text, sizeof(cellB.text), "CV B in: %d", module->nCVBChannels);
 			} else {
-				nvgFillColor(ctx.vg, nvgRGBA(0x00, 0xFF, 0xFF, 0xFF));
-				snprintf(text, sizeof(text), "%02d %f", i + 1, module->cvB[i]);
+				snprintf(cellB.text, sizeof(cellB.text), "No CV B in");
 			}
-			nvgText(ctx.vg, box.pos.x + 110, box.pos.y + i * 16 + j * 16, text, NULL);		
+		}
 
-			if (module->oper[module->currAlgo][i]->isValid()) {
-				nvgFillColor(ctx.vg, nvgRGBA(0x00, 0xFF, 0xFF, 0xFF));
-				snprintf(text, sizeof(text), "%s", module->oper[module->currAlgo][i]->asString().c_str());
-			} else {
-				nvgFillColor(ctx.vg, nvgRGBA(0x00, 0xFF, 0xFF, 0x6F));
-				snprintf(text, sizeof(text), "--");
+		if (module->currAlgo == PolyProbe::CHORD) {
+			Cell &chordCell = header[2];
+			int chord = module->chord;
+			int root = module->chordRoot;
+			int bass = module->chordBass;
+			if (update(chordCell, (chord * 12 + root) * 12 + bass, chord >= 0)) {
+				if (!chordCell.active) {
+					snprintf(chordCell.text, sizeof(chordCell.text), "No chord");
+				} else if (root == bass) {
+					snprintf(chordCell.text, sizeof(chordCell.text), "%s%s", music::noteNames[root].c_str(), 
+						music::BasicChordSet[chord].name.c_str());
+				} else {
+					snprintf(chordCell.text, sizeof(chordCell.text), "%s%s/%s", music::noteNames[root].c_str(), 
+						music::BasicChordSet[chord].name.c_str(), music::noteNames[bass].c_str());
+				}
+			}
+		}
+
+		if (module->currAlgo == PolyProbe::STATS) {
+			const float *values[5] = {module->stats.min, module->stats.max, module->stats.mean, module->stats.rms, module->stats.peak};
+			for (int s = 0; s < 5; s++) {
+				for (int i = 0; i < 16; i++) {
+					Cell &cell = statCells[s][i];
+					bool active = i < module->nCVAChannels;
+					if (update(cell, active ? statKey(values[s][i]) : (int64_t)INACTIVE, active)) {
+						if (active) {
+							snprintf(cell.text, sizeof(cell.text), "%.2f", values[s][i]);
+						} else {
+							snprintf(cell.text, sizeof(cell.text), "--");
+						}
+					}
+				}
+			}
+		}
+
+		for (int i = 0; i < 16; i++)  {
+
+			Cell &a = cells[0][i];
+			bool aActive = i < module->nCVAChannels;
+			if (update(a, aActive ? voltsKey(module->cvA[i]) : (int64_t)INACTIVE, aActive)) {
+				if (aActive) {
+					snprintf(a.text, sizeof(a.text), "%02d %f", i + 1, module->cvA[i]);
+				} else {
+					snprintf(a.text, sizeof(a.text), "%02d --", i + 1);
+				}
+			}
+
+			Cell &b = cells[1][i];
+			bool bActive = i < module->nCVBChannels;
+			if (update(b, bActive ? voltsKey(module->cvB[i]) : (int64_t)INACTIVE, bActive)) {
+				if (bActive) {
+					snprintf(b.text, sizeof(b.text), "%02d %f", i + 1, module->cvB[i]);
+				} else {
+					snprintf(b.text, sizeof(b.text), "%02d --", i + 1);
+				}
 			}
-			nvgText(ctx.vg, box.pos.x + 215, box.pos.y + i * 16 + j * 16, text, NULL);
+
+			Cell &r = cells[2][i];
+			bool rActive = module->valid & (1 << i);
+			if (update(r, rActive ? resultKey(i) : (int64_t)INACTIVE, rActive)) {
+				if (rActive) {
+					formatResult(i, r.text, sizeof(r.text));
+				} else {
+					snprintf(r.text, sizeof(r.text), "--");
+				}
+			}
+
+		}
+
+	}
+
+	void drawCell(NVGcontext *vg, const Cell &cell, float x, float y) {
+		nvgFillColor(vg, nvgRGBA(0x00, 0xFF, 0xFF, cell.active ? 0xFF : 0x6F));
+		nvgText(vg, x, y, cell.text, NULL);
+	}
+
+	void draw(const DrawArgs &ctx) override {
+
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		if (lastAlgo < 0 || now - lastRefresh >= std::chrono::microseconds(1000000 / module->displayRate)) {
+			lastRefresh = now;
+			refresh();
+		}
+
+		nvgFontSize(ctx.vg, 14);
+		nvgFontFaceId(ctx.vg, font->handle);
+		nvgTextLetterSpacing(ctx.vg, -1);
+		nvgTextAlign(ctx.vg, NVG_ALIGN_LEFT);
+
+		drawCell(ctx.vg, header[0], box.pos.x + 5, box.pos.y);
+		drawCell(ctx.vg, header[1], box.pos.x + 5, box.pos.y + 16);
+		if (module->currAlgo == PolyProbe::CHORD) {
+			drawCell(ctx.vg, header[2], box.pos.x + 215, box.pos.y);
+		}
+
+		if (module->currAlgo == PolyProbe::STATS) {
+			static const char *labels[5] = {"Min", "Max", "Mean", "RMS", "Peak"};
+			nvgFillColor(ctx.vg, nvgRGBA(0x00, 0xFF, 0xFF, 0xFF));
+			for (int s = 0; s < 5; s++) {
+				nvgText(ctx.vg, box.pos.x + 25 + s * 50, box.pos.y + 32, labels[s], NULL);
+			}
+			for (int i = 0; i < 16; i++)  {
+				float y = box.pos.y + (i + 3) * 16;
+				char channel[4];
+				snprintf(channel, sizeof(channel), "%02d", i + 1);
+				nvgFillColor(ctx.vg, nvgRGBA(0x00, 0xFF, 0xFF, i < module->nCVAChannels ? 0xFF : 0x6F));
+				nvgText(ctx.vg, box.pos.x + 5, y, channel, NULL);
+				for (int s = 0; s < 5; s++) {
+					drawCell(ctx.vg, statCells[s][i], box.pos.x + 25 + s * 50, y);
+				}
+			}
+			return;
+		}
+
+		for (int i = 0; i < 16; i++)  {
+			float y = box.pos.y + (i + 3) * 16;
+			drawCell(ctx.vg, cells[0][i], box.pos.x + 5, y);
+			drawCell(ctx.vg, cells[1][i], box.pos.x + 110, y);
+			drawCell(ctx.vg, cells[2][i], box.pos.x + 215, y);
 		}
 	}
 
@@ -343,9 +522,11 @@ struct PolyProbeWidget : ModuleWidget {
 				std::vector<PolyProbe::Algorithms> algo = {
 					PolyProbe::Algorithms::SUM, 
 					PolyProbe::Algorithms::DIFF, 
-					PolyProbe::Algorithms::NOTE
+					PolyProbe::Algorithms::NOTE,
+					PolyProbe::Algorithms::CHORD,
+					PolyProbe::Algorithms::STATS
 				};
-				std::vector<std::string> names = {"A+B", "A-B", "Note(A+B)"};
+				std::vector<std::string> names = {"A+B", "A-B", "Note(A+B)", "Chord(A)", "Stats(A)"};
 				for (size_t i = 0; i < algo.size(); i++) {
 					AlgoItem *item = createMenuItem<AlgoItem>(names[i], CHECKMARK(module->currAlgo == algo[i]));
 					item->module = module;
@@ -356,11 +537,76 @@ struct PolyProbeWidget : ModuleWidget {
 			}
 		};
 
+		struct RateItem : MenuItem {
+			PolyProbe *module;
+			int rate;
+			void onAction(const rack::event::Action &e) override {
+				module->displayRate = rate;
+			}
+		};
+
+		struct RateMenu : MenuItem {
+			PolyProbe *module;
+			Menu *createChildMenu() override {
+				Menu *menu = new Menu;
+				std::vector<int> rates = {5, 15, 30, 60};
+				for (size_t i = 0; i < rates.size(); i++) {
+					RateItem *item = createMenuItem<RateItem>(string::f("%d Hz", rates[i]), CHECKMARK(module->displayRate == rates[i]));
+					item->module = module;
+					item->rate = rates[i];
+					menu->addChild(item);
+				}
+				return menu;
+			}
+		};
+
+		struct WindowItem : MenuItem {
+			PolyProbe *module;
+			float window;
+			void onAction(const rack::event::Action &e) override {
+				module->statsWindow = window;
+			}
+		};
+
+		struct WindowMenu : MenuItem {
+			PolyProbe *module;
+			Menu *createChildMenu() override {
+				Menu *menu = new Menu;
+				std::vector<float> windows = {0.1f, 0.5f, 1.0f, 2.0f, 5.0f, 10.0f};
+				for (size_t i = 0; i < windows.size(); i++) {
+					WindowItem *item = createMenuItem<WindowItem>(string::f("%g s", windows[i]), CHECKMARK(module->statsWindow == windows[i]));
+					item->module = module;
+					item->window = windows[i];
+					menu->addChild(item);
+				}
+				return menu;
+			}
+		};
+
+		struct ResetPeaksItem : MenuItem {
+			PolyProbe *module;
+			void onAction(const rack::event::Action &e) override {
+				module->resetPeaks = true;
+			}
+		};
+
 		menu->addChild(construct<MenuLabel>());
 		AlgoMenu *algoItem = createMenuItem<AlgoMenu>("Operation");
 		algoItem->module = probe;
 		menu->addChild(algoItem);
 
+		RateMenu *rateItem = createMenuItem<RateMenu>("Display refresh");
+		rateItem->module = probe;
+		menu->addChild(rateItem);
+
+		WindowMenu *windowItem = createMenuItem<WindowMenu>("Statistics window");
+		windowItem->module = probe;
+		menu->addChild(windowItem);
+
+		ResetPeaksItem *peaksItem = createMenuItem<ResetPeaksItem>("Reset peaks");
+		peaksItem->module = probe;
+		menu->addChild(peaksItem);
+
 	}
 
 };
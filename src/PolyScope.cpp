@@ -1,5 +1,8 @@
 #include <array>
+#include <chrono>
+#include <memory>
 #include <string.h>
+#include <thread>
 #include <osdialog.h>
 
 #include "AH.hpp"
@@ -8,76 +11,118 @@
 #include <iostream>
 
 static const int BUFFER_SIZE = 512;
+static const int FFT_SIZE = 2048;
+static const int SPECTRUM_BINS = 128;
 
 using namespace ah;
 
 typedef std::array<NVGcolor, 16> colourMap;
 
-colourMap cMaps[6];
+// The built-in colour maps, built once when the plugin is loaded and read-only after that
+struct ColourMapRegistry {
 
-/** 
- * PolyScope, based on Andrew Belt's Scope module.
- */
-struct PolyScope : core::AHModule {
-	enum ParamIds {
-		SCALE_PARAM,
-		SPREAD_PARAM,
-		TIME_PARAM,
-		SHIFT_PARAM,
-		NUM_PARAMS
-	};
-	enum InputIds {
-		POLY_INPUT,
-		NUM_INPUTS
-	};
-	enum OutputIds {
-		NUM_OUTPUTS
-	};
-	enum LightIds {
-		NUM_LIGHTS
-	};
+	static const int NUM_MAPS = 5;
 
-	float buffer[16][BUFFER_SIZE] = {};
-	int bufferIndex = 0;
-	float frameIndex = 0;
-	int maxChannels;
+	colourMap maps[NUM_MAPS];
 
-	bool toggle = false;
+	ColourMapRegistry() {
 
-	int currCMap = 1;
-	std::string path;
-	std::string directory;
+		maps[0] = { // Classic
+		nvgRGBA(255,	0,		0,		240),	// 0	100		100
+		nvgRGBA(223,	0,		32,		240),	// 351	100		87
+		nvgRGBA(191,	0,		64,		240),	// 339	100		74
+		nvgRGBA(159,	0,		96,		240),	// 323	100		62
+		nvgRGBA(128,	0,		128,	240),	// 300	100		50
+		nvgRGBA(96,		0,		159,	240),	// 276	100		62
+		nvgRGBA(64,		0,		191,	240),	// 260	100		74
+		nvgRGBA(32,		0,		223,	240),	// 248	100		91
+		nvgRGBA(0,		32,		223,	240),	// 231	120		91
+		nvgRGBA(0,		64,		191,	240),	// 219	100		74
+		nvgRGBA(0,		96,		159,	240),	// 203	100		62
+		nvgRGBA(0,		128,	128,	240),	// 180	100		50
+		nvgRGBA(0,		159,	96,		240),	// 156	100		62
+		nvgRGBA(0,		191,	64,		240),	// 140	100		74
+		nvgRGBA(0,		223,	32,		240),	// 128	100		87
+		nvgRGBA(0,		255,	0,		240)};	// 120	100		100
+
+		maps[1] = { // Constant V
+		nvgRGBA(255,	0,		0,		240),	// 0	100		100
+		nvgRGBA(255,	0,		38,		240),	// 351	100		87
+		nvgRGBA(255,	0,		89,		240),	// 339	100		74
+		nvgRGBA(255,	0,		157,	240),	// 323	100		62
+		nvgRGBA(255,	0,		255,	240),	// 300	100		50
+		nvgRGBA(152,	0,		255,	240),	// 276	100		62
+		nvgRGBA(84,		0,		255,	240),	// 260	100		74
+		nvgRGBA(34,		0,		255,	240),	// 248	100		91
+		nvgRGBA(0,		38,		255,	240),	// 231	100		91
+		nvgRGBA(0,		89,		255,	240),	// 219	100		74
+		nvgRGBA(0,		157,	159,	240),	// 203	100		62
+		nvgRGBA(0,		255,	255,	240),	// 180	100		50
+		nvgRGBA(0,		255,	153,	240),	// 156	100		62
+		nvgRGBA(0,		255,	85,		240),	// 140	100		74
+		nvgRGBA(0,		255,	33,		240),	// 128	100		87
+		nvgRGBA(0,		255,	0,		240)};	// 120	100		100
 
-	dsp::SchmittTrigger resetTrigger;
+		float dHue = 1.0f/16.0f;
 
-	void loadCMap(const char *path) {
+		for (int i = 0; i < 16; i++) {
+			maps[2][i] = nvgHSL(1 - i * dHue * 2.0f/3.0f, 1.0f, 0.7f ); // Constant L, HSL L=0.7
+		}
 
-		// Empty path, so bail 
-		if (path[0] == '\0') {
-			return;
+		for (int i = 0; i < 16; i++) {
+			maps[3][i] = nvgHSL(1 - i * dHue, 1.0f, 0.7f ); // Full Circle, HSL L=0.7
+		}
+
+		for (int i = 0; i < 16; i++) {
+			maps[4][i] = nvgHSL(2.0f/3.0f + i * dHue * 1.0f/6.0f, 1.0f, 0.6f ); // Synthwave L=0.5
 		}
 
-		FILE *file = fopen(path, "r");
+	}
+
+};
+
+static const ColourMapRegistry colourMaps;
+
+// A colour scheme file parsed on a worker thread and picked up by the UI thread once state is no longer PENDING
+struct CMapJob {
+
+	enum State {
+		PENDING,
+		LOADED,
+		FAILED
+	};
+
+	std::string path;
+	bool select = false; // Switch to the user map once loaded
+	colourMap cMap;
+	std::string error;
+	std::atomic<int> state {PENDING};
+
+	void parse() {
+
+		FILE *file = fopen(path.c_str(), "r");
 		if (!file) {
-				WARN("Could not load colour scheme file %s", path);
-				return;
+			WARN("Could not load colour scheme file %s", path.c_str());
+			error = "Could not open " + string::filename(path);
+			state = FAILED;
+			return;
 		}
 		DEFER({
-				fclose(file);
+			fclose(file);
 		});
 
-		json_error_t error;
-		json_t *rootJ = json_loadf(file, 0, &error);
+		json_error_t jsonError;
+		json_t *rootJ = json_loadf(file, 0, &jsonError);
 		if (!rootJ) {
-				std::string message = string::f("File is not a valid colour scheme file. JSON parsing error at %s %d:%d %s", error.source, error.line, error.column, error.text);
-				osdialog_message(OSDIALOG_WARNING, OSDIALOG_OK, message.c_str());
-				return;
+			error = string::f("Not a valid colour scheme file, JSON error at %d:%d %s", jsonError.line, jsonError.column, jsonError.text);
+			state = FAILED;
+			return;
 		}
 		DEFER({
-				json_decref(rootJ);
+			json_decref(rootJ);
 		});
 
-		this->path = path;
+		cMap.fill(nvgRGBf(1.0f, 1.0f, 1.0f));
 
 		for (int i = 0; i < 16; i++) {
 
@@ -102,82 +147,163 @@ struct PolyScope : core::AHModule {
 				if (bJ)
 					b = json_integer_value(bJ);
 
-				cMaps[5][i] = nvgRGBA(r, g, b, 240);
+				cMap[i] = nvgRGBA(r, g, b, 240);
 
 			}
 		}
 
-		currCMap = 5;
+		state = LOADED;
 
 	}
 
-	PolyScope() : core::AHModule(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS) { 
-		configParam(SCALE_PARAM, -2.0f, 2.0f, 0.0f);
-		configParam(SPREAD_PARAM, 0.0f, 3.0f, 1.0f);
-		configParam(TIME_PARAM, 6.0f, 16.0f, 14.0f);
-		configParam(SHIFT_PARAM, -16.0f, 16.0f, 0.0f);
+};
 
-		cMaps[0] = { // Classic
-		nvgRGBA(255,	0,		0,		240),	// 0	100		100
-		nvgRGBA(223,	0,		32,		240),	// 351	100		87
-		nvgRGBA(191,	0,		64,		240),	// 339	100		74
-		nvgRGBA(159,	0,		96,		240),	// 323	100		62
-		nvgRGBA(128,	0,		128,	240),	// 300	100		50
-		nvgRGBA(96,		0,		159,	240),	// 276	100		62
-		nvgRGBA(64,		0,		191,	240),	// 260	100		74
-		nvgRGBA(32,		0,		223,	240),	// 248	100		91
-		nvgRGBA(0,		32,		223,	240),	// 231	120		91
-		nvgRGBA(0,		64,		191,	240),	// 219	100		74
-		nvgRGBA(0,		96,		159,	240),	// 203	100		62
-		nvgRGBA(0,		128,	128,	240),	// 180	100		50
-		nvgRGBA(0,		159,	96,		240),	// 156	100		62
-		nvgRGBA(0,		191,	64,		240),	// 140	100		74
-		nvgRGBA(0,		223,	32,		240),	// 128	100		87
-		nvgRGBA(0,		255,	0,		240)};	// 120	100		100
+/** 
+ * PolyScope, based on Andrew Belt's Scope module.
+ */
+struct PolyScope : core::AHModule {
+	enum ParamIds {
+		SCALE_PARAM,
+		SPREAD_PARAM,
+		TIME_PARAM,
+		SHIFT_PARAM,
+		NUM_PARAMS
+	};
+	enum InputIds {
+		POLY_INPUT,
+		NUM_INPUTS
+	};
+	enum OutputIds {
+		NUM_OUTPUTS
+	};
+	enum LightIds {
+		NUM_LIGHTS
+	};
 
-		cMaps[1] = { // Constant V
-		nvgRGBA(255,	0,		0,		240),	// 0	100		100
-		nvgRGBA(255,	0,		38,		240),	// 351	100		87
-		nvgRGBA(255,	0,		89,		240),	// 339	100		74
-		nvgRGBA(255,	0,		157,	240),	// 323	100		62
-		nvgRGBA(255,	0,		255,	240),	// 300	100		50
-		nvgRGBA(152,	0,		255,	240),	// 276	100		62
-		nvgRGBA(84,		0,		255,	240),	// 260	100		74
-		nvgRGBA(34,		0,		255,	240),	// 248	100		91
-		nvgRGBA(0,		38,		255,	240),	// 231	100		91
-		nvgRGBA(0,		89,		255,	240),	// 219	100		74
-		nvgRGBA(0,		157,	159,	240),	// 203	100		62
-		nvgRGBA(0,		255,	255,	240),	// 180	100		50
-		nvgRGBA(0,		255,	153,	240),	// 156	100		62
-		nvgRGBA(0,		255,	85,		240),	// 140	100		74
-		nvgRGBA(0,		255,	33,		240),	// 128	100		87
-		nvgRGBA(0,		255,	0,		240)};	// 120	100		100
+	enum DisplayMode {
+		WAVEFORM,
+		SPECTRUM,
+		XY
+	};
 
-		float dHue = 1.0f/16.0f;
+	DisplayMode displayMode = WAVEFORM;
 
-		for (int i = 0; i < 16; i++) {
-			cMaps[2][i] = nvgHSL(1 - i * dHue * 2.0f/3.0f, 1.0f, 0.7f ); // Constant L, HSL L=0.7
+	float buffer[16][BUFFER_SIZE] = {};
+	int bufferIndex = 0;
+	float frameIndex = 0;
+	int maxChannels;
+
+	bool toggle = false;
+
+	// 0 to NUM_MAPS - 1 are the built-in maps, NUM_MAPS is this instance's user map
+	int currCMap = 1;
+	colourMap userCMap;
+	std::string path;
+	std::string directory;
+
+	// Trigger on an edge of one channel, found by scanning blocks of samples. The channel has to go further than
+	// TRIGGER_HYSTERESIS the other side of the level to arm the trigger, so that noise around the level does not retrigger
+	static const int TRIGGER_BLOCK = 16;
+	static constexpr float TRIGGER_HYSTERESIS = 0.1f;
+	int triggerChannel = 0;
+	float triggerLevel = 0.0f;
+	bool triggerRising = true;
+
+	float pending[TRIGGER_BLOCK][16];
+	float trigSamples[TRIGGER_BLOCK] = {}; // The trigger channel
+	bool trigArmed = false;
+	int pendingCount = 0;
+	int waited = 0;
+
+	std::shared_ptr<CMapJob> cMapJob; // Only accessed through std::atomic_load/store
+
+	// Starts loading a colour scheme file on a worker thread, see collectCMap()
+	void loadCMap(const std::string &cMapPath, bool select) {
+
+		// Empty path, so bail 
+		if (cMapPath.empty()) {
+			return;
 		}
 
-		for (int i = 0; i < 16; i++) {
-			cMaps[3][i] = nvgHSL(1 - i * dHue, 1.0f, 0.7f ); // Full Circle, HSL L=0.7
+		std::shared_ptr<CMapJob> job = std::make_shared<CMapJob>();
+		job->path = cMapPath;
+		job->select = select;
+		std::atomic_store(&cMapJob, job);
+
+		// The job is shared with the worker, so it outlives the module if needs be
+		std::thread([job]() {
+			job->parse();
+		}).detach();
+
+	}
+
+	/*
+	* Called from the UI thread, installs the user map from a finished load. Returns the finished job, 
+	* successful or not, or NULL if there is none
+	*/
+	std::shared_ptr<CMapJob> collectCMap() {
+
+		std::shared_ptr<CMapJob> job = std::atomic_load(&cMapJob);
+		if (!job || job->state == CMapJob::PENDING) {
+			return NULL;
 		}
 
-		for (int i = 0; i < 16; i++) {
-			cMaps[4][i] = nvgHSL(2.0f/3.0f + i * dHue * 1.0f/6.0f, 1.0f, 0.6f ); // Synthwave L=0.5
+		// Leave a newer job in place
+		if (!std::atomic_compare_exchange_strong(&cMapJob, &job, std::shared_ptr<CMapJob>())) {
+			return NULL;
 		}
 
-		for (int i = 0; i < 16; i++) {
-			cMaps[5][i] = nvgRGBf(1.0f, 1.0f, 1.0f); // User defined, start with all white
+		if (job->state == CMapJob::LOADED) {
+			userCMap = job->cMap;
+			path = job->path;
+			if (job->select) {
+				currCMap = ColourMapRegistry::NUM_MAPS;
+			}
 		}
 
+		return job;
+
+	}
+
+	const colourMap &getCMap() const {
+		if (currCMap >= 0 && currCMap < ColourMapRegistry::NUM_MAPS) {
+			return colourMaps.maps[currCMap];
+		}
+		return userCMap;
+	}
+
+	PolyScope() : core::AHModule(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS) { 
+		configParam(SCALE_PARAM, -2.0f, 2.0f, 0.0f);
+		configParam(SPREAD_PARAM, 0.0f, 3.0f, 1.0f);
+		configParam(TIME_PARAM, 6.0f, 16.0f, 14.0f);
+		configParam(SHIFT_PARAM, -16.0f, 16.0f, 0.0f);
+
+		userCMap.fill(nvgRGBf(1.0f, 1.0f, 1.0f)); // Start with all white
+
+		for (int i = 0; i < 3; i++) {
+			sweeps.slots[i].sequence = 0;
+			sweeps.slots[i].channels = 0;
+			spectra.slots[i].channels = 0;
+		}
+		spectrumWorker = std::thread(&PolyScope::processSpectra, this);
+
 	}
 
 	json_t *dataToJson() override {
 		json_t *rootJ = json_object();
 
 		json_object_set_new(rootJ, "cmap", json_integer((int) currCMap));
-		json_object_set_new(rootJ, "path", json_string(path.c_str()));
+		// A scheme still loading is saved as if it had finished
+		std::shared_ptr<CMapJob> job = std::atomic_load(&cMapJob);
+		json_object_set_new(rootJ, "path", json_string((job ? job->path : path).c_str()));
+
+		// displayMode
+		json_object_set_new(rootJ, "displayMode", json_integer((int) displayMode));
+
+		// trigger
+		json_object_set_new(rootJ, "triggerChannel", json_integer(triggerChannel));
+		json_object_set_new(rootJ, "triggerLevel", json_real(triggerLevel));
+		json_object_set_new(rootJ, "triggerRising", json_boolean(triggerRising));
 
 		return rootJ;
 	}
@@ -189,8 +315,26 @@ struct PolyScope : core::AHModule {
 			currCMap = json_integer_value(cMapJ);
 
 		json_t *pathJ = json_object_get(rootJ, "path");
-		if (pathJ)
-			loadCMap(json_string_value(pathJ));
+		if (json_is_string(pathJ))
+			loadCMap(json_string_value(pathJ), false);
+
+		// displayMode
+		json_t *displayModeJ = json_object_get(rootJ, "displayMode");
+		if (displayModeJ)
+			displayMode = (DisplayMode)clamp((int)json_integer_value(displayModeJ), 0, (int)XY);
+
+		// trigger
+		json_t *triggerChannelJ = json_object_get(rootJ, "triggerChannel");
+		if (triggerChannelJ)
+			triggerChannel = clamp((int)json_integer_value(triggerChannelJ), 0, 15);
+
+		json_t *triggerLevelJ = json_object_get(rootJ, "triggerLevel");
+		if (triggerLevelJ)
+			triggerLevel = json_number_value(triggerLevelJ);
+
+		json_t *triggerRisingJ = json_object_get(rootJ, "triggerRising");
+		if (triggerRisingJ)
+			triggerRising = json_is_true(triggerRisingJ);
 
 	}
 
@@ -199,6 +343,134 @@ struct PolyScope : core::AHModule {
 		path = "";
 	}
 
+	// Spectrum mode: the audio thread only copies sweeps of FFT_SIZE samples, a worker does the FFTs
+	struct Sweep {
+		float samples[16][FFT_SIZE];
+		float sampleRate;
+		int channels;
+		uint32_t sequence;
+	};
+
+	// Magnitudes in dB relative to 10V on SPECTRUM_BINS log-spaced bins from MIN_FREQUENCY to Nyquist
+	struct Spectrum {
+		float db[16][SPECTRUM_BINS];
+		int channels;
+	};
+
+	static constexpr float MIN_FREQUENCY = 20.0f;
+
+	core::TripleBuffer<Sweep> sweeps;
+	core::TripleBuffer<Spectrum> spectra;
+	int sweepIndex = 0;
+	uint32_t sweepSequence = 0;
+
+	std::thread spectrumWorker;
+	std::atomic<bool> running {true};
+
+	~PolyScope() {
+		running = false;
+		spectrumWorker.join();
+	}
+
+	void processSpectra() {
+
+		dsp::RealFFT fft(FFT_SIZE);
+		alignas(16) float windowed[FFT_SIZE];
+		alignas(16) float transformed[FFT_SIZE];
+
+		float window[FFT_SIZE];
+		for (int i = 0; i < FFT_SIZE; i++) {
+			window[i] = 0.5f * (1.0f - std::cos(2.0f * (float)core::PI * i / FFT_SIZE)); // Hann
+		}
+
+		// A full scale sine has a peak of N/4 through the Hann window
+		float scale = 4.0f / (FFT_SIZE * 10.0f);
+
+		// The FFT bins each display bin covers, redone when the sample rate changes
+		int firstBin[SPECTRUM_BINS + 1];
+		float binsFor = 0.0f;
+
+		uint32_t lastSequence = 0;
+
+		while (running) {
+
+			std::this_thread::sleep_for(std::chrono::milliseconds(30));
+
+			const Sweep &sweep = sweeps.read();
+			if (sweep.sequence == lastSequence || displayMode != SPECTRUM) {
+				continue;
+			}
+			lastSequence = sweep.sequence;
+
+			if (sweep.sampleRate != binsFor) {
+				binsFor = sweep.sampleRate;
+				float nyquist = binsFor / 2.0f;
+				for (int b = 0; b <= SPECTRUM_BINS; b++) {
+					float f = MIN_FREQUENCY * std::pow(nyquist / MIN_FREQUENCY, (float)b / SPECTRUM_BINS);
+					firstBin[b] = clamp((int)std::round(f * FFT_SIZE / binsFor), 1, FFT_SIZE / 2);
+				}
+			}
+
+			Spectrum &spectrum = spectra.getBack();
+			spectrum.channels = sweep.channels;
+			for (int c = 0; c < sweep.channels; c++) {
+				for (int i = 0; i < FFT_SIZE; i++) {
+					windowed[i] = sweep.samples[c][i] * window[i];
+				}
+				fft.rfft(windowed, transformed);
+
+				// Ordered output is Re(0), Re(N/2), then Re(k), Im(k) pairs. Each display bin shows its loudest FFT bin, 
+				// at low frequencies several display bins share one
+				for (int b = 0; b < SPECTRUM_BINS; b++) {
+					float peak = 0.0f;
+					int last = std::max(firstBin[b] + 1, firstBin[b + 1]);
+					for (int k = firstBin[b]; k < last && k < FFT_SIZE / 2; k++) {
+						float re = transformed[2 * k];
+						float im = transformed[2 * k + 1];
+						peak = std::max(peak, re * re + im * im);
+					}
+					spectrum.db[c][b] = 10.0f * std::log10(peak * scale * scale + 1e-12f);
+				}
+			}
+			spectra.publish();
+
+		}
+
+	}
+
+	void captureSpectrum(const float *in, float sampleRate) {
+		Sweep &sweep = sweeps.getBack();
+		for (int c = 0; c < 16; c++) {
+			sweep.samples[c][sweepIndex] = in[c];
+		}
+		if (++sweepIndex >= FFT_SIZE) {
+			sweep.sampleRate = sampleRate;
+			sweep.channels = maxChannels;
+			sweep.sequence = ++sweepSequence;
+			sweeps.publish();
+			sweepIndex = 0;
+		}
+	}
+
+	// X/Y mode: decimated frames for the phosphor display, which draws and drops them every UI frame
+	struct XYFrame {
+		float v[16];
+	};
+
+	dsp::RingBuffer<XYFrame, 4096> xyFrames;
+	int xyIndex = 0;
+
+	void captureXY(const float *in, int frameCount) {
+		if (++xyIndex > frameCount) {
+			xyIndex = 0;
+			if (!xyFrames.full()) {
+				XYFrame frame;
+				std::copy(in, in + 16, frame.v);
+				xyFrames.push(frame);
+			}
+		}
+	}
+
 	void process(const ProcessArgs &args) override {
 
 		// Compute time
@@ -207,45 +479,94 @@ struct PolyScope : core::AHModule {
 
 		maxChannels = inputs[POLY_INPUT].getChannels();
 
+		const float *in = inputs[POLY_INPUT].getVoltages();
+
+		if (displayMode == SPECTRUM) {
+			captureSpectrum(in, args.sampleRate);
+			return;
+		}
+
+		if (displayMode == XY) {
+			captureXY(in, frameCount);
+			return;
+		}
+
 		// Add frame to buffer
 		if (bufferIndex < BUFFER_SIZE) {
-			if (++frameIndex > frameCount) {
-				for (int i = 0; i < 16; i++) {
-					buffer[i][bufferIndex] = inputs[POLY_INPUT].getVoltage(i);
-				}
-				bufferIndex++;
-				frameIndex = 0;
+			capture(in, frameCount);
+			return;
+		}
+
+		// Waiting on the next trigger, hold the frames until there is a block to scan
+		for (int k = 0; k < 16; k += 4) {
+			simd::float_4::load(in + k).store(pending[pendingCount] + k);
+		}
+		trigSamples[pendingCount] = in[triggerChannel];
+		pendingCount++;
+		waited++;
+
+		if (pendingCount < TRIGGER_BLOCK) {
+			return;
+		}
+
+		int at = findTrigger();
+
+		// Free-run if we've waited too long
+		float holdTime = 0.1f;
+		if (at < 0 && waited >= args.sampleRate * holdTime) {
+			at = TRIGGER_BLOCK;
+		}
+
+		pendingCount = 0;
+
+		// Restart the sweep from the trigger point, replaying the frames after it
+		if (at >= 0) {
+			bufferIndex = 0;
+			frameIndex = 0;
+			for (int i = at; i < TRIGGER_BLOCK && bufferIndex < BUFFER_SIZE; i++) {
+				capture(pending[i], frameCount);
 			}
 		}
 
-		// Are we waiting on the next trigger?
-		if (bufferIndex >= BUFFER_SIZE) {
-			// Reset the Schmitt trigger so we don't trigger immediately if the input is high
-			if (frameIndex == 0) {
-				resetTrigger.reset();
+	}
+
+	void capture(const float *frame, int frameCount) {
+		if (++frameIndex > frameCount) {
+			for (int i = 0; i < 16; i++) {
+				buffer[i][bufferIndex] = frame[i];
 			}
-			frameIndex++;
-
-			// Must go below 0.1fV to trigger
-			float gate = inputs[POLY_INPUT].getVoltage(0);
-
-			// Reset if triggered
-			float holdTime = 0.1f;
-			float trigParam = 0.0f;
-			if (resetTrigger.process(rescale(gate, trigParam - 0.1f, trigParam, 0.f, 1.f)) || (frameIndex >= args.sampleRate * holdTime)) {
-				bufferIndex = 0; 
-				frameIndex = 0; 
-				return;
+			bufferIndex++;
+			frameIndex = 0;
+
+			// Sweep done, arm the trigger so that it waits for an edge rather than firing on a level
+			if (bufferIndex >= BUFFER_SIZE) {
+				pendingCount = 0;
+				waited = 0;
+				trigArmed = false;
 			}
+		}
+	}
 
-			// Reset if we've waited too long
-			if (frameIndex >= args.sampleRate * holdTime) {
-				bufferIndex = 0; 
-				frameIndex = 0; 
-				return;
+	// Index in the pending block of the first sample to reach the trigger level in the chosen direction once armed, or -1
+	int findTrigger() {
+		float sign = triggerRising ? 1.0f : -1.0f;
+		float level = triggerLevel * sign;
+		for (int k = 0; k < TRIGGER_BLOCK; k += 4) {
+			simd::float_4 x = simd::float_4::load(trigSamples + k) * sign;
+			int below = simd::movemask(x < level - TRIGGER_HYSTERESIS);
+			int above = simd::movemask(x >= level);
+
+			// Armed from the first sample below the band onwards, or throughout if armed by an earlier block
+			int armed = trigArmed ? 0xf : -(below & -below) & 0xf;
+			int fired = above & armed;
+			if (fired) {
+				return k + __builtin_ctz(fired);
 			}
+			trigArmed = armed != 0;
 		}
+		return -1;
 	}
+
 };
 
 struct Patch : Widget {
@@ -271,7 +592,39 @@ struct PolyScopeDisplay : TransparentWidget {
 	float t = 0.0;
 	float d = 0.008;
 
-	PolyScopeDisplay() { }
+	// Colour scheme load failures are shown in the display for a few seconds rather than in a dialog
+	std::string message;
+	std::chrono::steady_clock::time_point messageExpiry;
+
+	PolyScopeDisplay() {
+		font = gui::getFont(gui::FONT_EUROSTILE);
+	}
+
+	void step() override {
+		if (module) {
+			std::shared_ptr<CMapJob> job = module->collectCMap();
+			if (job && job->state == CMapJob::FAILED) {
+				message = job->error;
+				messageExpiry = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+			}
+		}
+		TransparentWidget::step();
+	}
+
+	void drawMessage(const DrawArgs &args) {
+		if (message.empty()) {
+			return;
+		}
+		if (std::chrono::steady_clock::now() >= messageExpiry) {
+			message.clear();
+			return;
+		}
+		nvgFontSize(args.vg, 12);
+		nvgFontFaceId(args.vg, font->handle);
+		nvgTextAlign(args.vg, NVG_ALIGN_LEFT | NVG_ALIGN_TOP);
+		nvgFillColor(args.vg, nvgRGBA(0xFF, 0x60, 0x60, 0xFF));
+		nvgText(args.vg, 5, 0, message.c_str(), NULL);
+	}
 
 	void drawWaveform(const DrawArgs &args, float *valuesX) {
 		if (!valuesX)
@@ -303,10 +656,54 @@ struct PolyScopeDisplay : TransparentWidget {
 		nvgRestore(args.vg);
 	}
 
+	void drawSpectrum(const DrawArgs &args, const colourMap &cMap) {
+
+		const PolyScope::Spectrum &spectrum = module->spectra.read();
+
+		Rect b = Rect(Vec(0, 15), box.size.minus(Vec(0, 15*2)));
+		float dbFloor = -80.0f;
+
+		nvgSave(args.vg);
+		nvgScissor(args.vg, b.pos.x, b.pos.y, b.size.x, b.size.y);
+		nvgLineCap(args.vg, NVG_ROUND);
+		nvgMiterLimit(args.vg, 2.0f);
+		nvgStrokeWidth(args.vg, 1.25f);
+		nvgGlobalCompositeOperation(args.vg, NVG_LIGHTER);
+		for (int c = 0; c < std::min(spectrum.channels, module->maxChannels); c++) {
+			nvgBeginPath(args.vg);
+			for (int i = 0; i < SPECTRUM_BINS; i++) {
+				Vec p;
+				p.x = b.pos.x + b.size.x * i / (SPECTRUM_BINS - 1);
+				p.y = b.pos.y + b.size.y * clamp(spectrum.db[c][i] / dbFloor, 0.0f, 1.0f);
+				if (i == 0)
+					nvgMoveTo(args.vg, p.x, p.y);
+				else
+					nvgLineTo(args.vg, p.x, p.y);
+			}
+			nvgStrokeColor(args.vg, cMap[c]);
+			nvgStroke(args.vg);
+		}
+		nvgResetScissor(args.vg);
+		nvgRestore(args.vg);
+
+	}
+
 	void draw(const DrawArgs &args) override {
 		if (!module)
 			return;
 
+		if (module->displayMode == PolyScope::SPECTRUM) {
+			drawSpectrum(args, module->getCMap());
+			drawMessage(args);
+			return;
+		}
+
+		// Drawn by PolyScopeXY
+		if (module->displayMode == PolyScope::XY) {
+			drawMessage(args);
+			return;
+		}
+
 		if(module->toggle) {
 			t = t + d;
 			if ((t >= 1.0) || (t <= 0.0)) {
@@ -325,13 +722,119 @@ struct PolyScopeDisplay : TransparentWidget {
 			}
 		}
 
+		const colourMap &cMap = module->getCMap();
 		for (int i = 0; i < module->maxChannels; i++) {
-			nvgStrokeColor(args.vg, cMaps[module->currCMap][i]);
+			nvgStrokeColor(args.vg, cMap[i]);
 			drawWaveform(args, values[i]);
 		}
+
+		drawMessage(args);
 	}
 };
 
+/*
+* X/Y mode, channels 1 & 2, 3 & 4 and so on plotted against each other. The image persists in the framebuffer 
+* and fades a little with every update, which only draws the frames that arrived since the last one.
+*/
+struct PolyScopeXY : FramebufferWidget {
+
+	PolyScope *module = NULL;
+	std::vector<PolyScope::XYFrame> fresh;
+	PolyScope::XYFrame last = {};
+	// The framebuffer is recreated when its size or scale changes, which loses the image
+	math::Vec drawnSize;
+	math::Vec drawnScale;
+
+	float decay = 0.1f;
+
+	void step() override {
+		if (module && module->displayMode == PolyScope::XY) {
+			while (!module->xyFrames.empty()) {
+				fresh.push_back(module->xyFrames.shift());
+			}
+			if (!fresh.empty()) {
+				dirty = true;
+			}
+		}
+		FramebufferWidget::step();
+	}
+
+	void draw(const DrawArgs &args) override {
+		if (module && module->displayMode == PolyScope::XY) {
+			FramebufferWidget::draw(args);
+		}
+	}
+
+	Vec toPoint(const Rect &b, float x, float y, float gain) {
+		return Vec(b.pos.x + b.size.x * (0.5f + clamp(x * gain / 20.0f, -0.5f, 0.5f)),
+			b.pos.y + b.size.y * (0.5f - clamp(y * gain / 20.0f, -0.5f, 0.5f)));
+	}
+
+	void drawTraces(NVGcontext *vg) {
+
+		Rect b = Rect(Vec(0, 15), box.size.minus(Vec(0, 15*2)));
+
+		nvgGlobalCompositeOperation(vg, NVG_DESTINATION_OUT);
+		nvgBeginPath(vg);
+		nvgRect(vg, 0, 0, box.size.x, box.size.y);
+		nvgFillColor(vg, nvgRGBAf(0.0f, 0.0f, 0.0f, decay));
+		nvgFill(vg);
+
+		if (fresh.empty()) {
+			return;
+		}
+
+		float gain = std::pow(2.0f, module->params[PolyScope::SCALE_PARAM].getValue());
+		const colourMap &cMap = module->getCMap();
+
+		nvgGlobalCompositeOperation(vg, NVG_LIGHTER);
+		nvgLineCap(vg, NVG_ROUND);
+		nvgStrokeWidth(vg, 1.25f);
+		for (int pair = 0; pair < module->maxChannels / 2; pair++) {
+			int x = pair * 2;
+			int y = x + 1;
+			nvgBeginPath(vg);
+			Vec p = toPoint(b, last.v[x], last.v[y], gain);
+			nvgMoveTo(vg, p.x, p.y);
+			for (size_t i = 0; i < fresh.size(); i++) {
+				p = toPoint(b, fresh[i].v[x], fresh[i].v[y], gain);
+				nvgLineTo(vg, p.x, p.y);
+			}
+			nvgStrokeColor(vg, cMap[x]);
+			nvgStroke(vg);
+		}
+
+		last = fresh.back();
+		fresh.clear();
+
+	}
+
+	// As FramebufferWidget::drawFramebuffer(), but keeps what is already in the framebuffer
+	void drawFramebuffer() override {
+		NVGcontext *vg = APP->window->vg;
+		float pixelRatio = fbSize.x * oversample / fbBox.size.x;
+		nvgBeginFrame(vg, fbBox.size.x, fbBox.size.y, pixelRatio);
+		nvgTranslate(vg, -fbBox.pos.x, -fbBox.pos.y);
+		nvgTranslate(vg, fbOffset.x, fbOffset.y);
+		nvgScale(vg, fbScale.x, fbScale.y);
+
+		drawTraces(vg);
+
+		glViewport(0.0, 0.0, fbSize.x * oversample, fbSize.y * oversample);
+		if (!fbSize.isEqual(drawnSize) || !fbScale.isEqual(drawnScale)) {
+			drawnSize = fbSize;
+			drawnScale = fbScale;
+			glClearColor(0.0, 0.0, 0.0, 0.0);
+			glClear(GL_COLOR_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+		} else {
+			glClear(GL_STENCIL_BUFFER_BIT);
+		}
+		nvgEndFrame(vg);
+		nvgReset(vg);
+	}
+
+};
+
 static void loadCMap(PolyScope *module) {
 
 	std::string dir;
@@ -347,7 +850,7 @@ static void loadCMap(PolyScope *module) {
 
 	char *path = osdialog_file(OSDIALOG_OPEN, dir.c_str(), filename.c_str(), NULL);
 	if (path) {
-		module->loadCMap(path);
+		module->loadCMap(path, true);
 		free(path);
 	}
 }
@@ -365,6 +868,14 @@ struct PolyScopeWidget : ModuleWidget {
 			addChild(display);
 		}
 
+		{
+			PolyScopeXY *xy = new PolyScopeXY();
+			xy->module = module;
+			xy->box.pos = Vec(0, 20);
+			xy->box.size = Vec(345, 310);
+			addChild(xy);
+		}
+
 		{
 			Patch *patch = new Patch();
 			patch->module = module;
@@ -416,6 +927,102 @@ struct PolyScopeWidget : ModuleWidget {
 			}
 		};
 
+		struct TriggerChannelItem : MenuItem {
+			PolyScope *module;
+			int channel;
+			void onAction(const rack::event::Action &e) override {
+				module->triggerChannel = channel;
+			}
+		};
+
+		struct TriggerChannelMenu : MenuItem {
+			PolyScope *module;
+			Menu *createChildMenu() override {
+				Menu *menu = new Menu;
+				for (int i = 0; i < 16; i++) {
+					TriggerChannelItem *item = createMenuItem<TriggerChannelItem>(string::f("%d", i + 1), CHECKMARK(module->triggerChannel == i));
+					item->module = module;
+					item->channel = i;
+					menu->addChild(item);
+				}
+				return menu;
+			}
+		};
+
+		struct TriggerLevelItem : MenuItem {
+			PolyScope *module;
+			float level;
+			void onAction(const rack::event::Action &e) override {
+				module->triggerLevel = level;
+			}
+		};
+
+		struct TriggerLevelMenu : MenuItem {
+			PolyScope *module;
+			Menu *createChildMenu() override {
+				Menu *menu = new Menu;
+				std::vector<float> levels = {-5.0f, -1.0f, 0.0f, 0.5f, 1.0f, 2.5f, 5.0f};
+				for (size_t i = 0; i < levels.size(); i++) {
+					TriggerLevelItem *item = createMenuItem<TriggerLevelItem>(string::f("%gV", levels[i]), CHECKMARK(module->triggerLevel == levels[i]));
+					item->module = module;
+					item->level = levels[i];
+					menu->addChild(item);
+				}
+				return menu;
+			}
+		};
+
+		struct TriggerSlopeItem : MenuItem {
+			PolyScope *module;
+			bool rising;
+			void onAction(const rack::event::Action &e) override {
+				module->triggerRising = rising;
+			}
+		};
+
+		struct TriggerSlopeMenu : MenuItem {
+			PolyScope *module;
+			Menu *createChildMenu() override {
+				Menu *menu = new Menu;
+				std::vector<std::string> names = {"Rising", "Falling"};
+				for (size_t i = 0; i < names.size(); i++) {
+					TriggerSlopeItem *item = createMenuItem<TriggerSlopeItem>(names[i], CHECKMARK(module->triggerRising == (i == 0)));
+					item->module = module;
+					item->rising = (i == 0);
+					menu->addChild(item);
+				}
+				return menu;
+			}
+		};
+
+		struct DisplayModeItem : MenuItem {
+			PolyScope *module;
+			PolyScope::DisplayMode mode;
+			void onAction(const rack::event::Action &e) override {
+				module->displayMode = mode;
+			}
+		};
+
+		struct DisplayModeMenu : MenuItem {
+			PolyScope *module;
+			Menu *createChildMenu() override {
+				Menu *menu = new Menu;
+				std::vector<PolyScope::DisplayMode> modes = {PolyScope::WAVEFORM, PolyScope::SPECTRUM, PolyScope::XY};
+				std::vector<std::string> names = {"Waveform", "Spectrum", "X/Y"};
+				for (size_t i = 0; i < modes.size(); i++) {
+					DisplayModeItem *item = createMenuItem<DisplayModeItem>(names[i], CHECKMARK(module->displayMode == modes[i]));
+					item->module = module;
+					item->mode = modes[i];
+					menu->addChild(item);
+				}
+				return menu;
+			}
+		};
+
+		DisplayModeMenu *modeItem = createMenuItem<DisplayModeMenu>("Display");
+		modeItem->module = scope;
+		menu->addChild(modeItem);
+
 		ColourMenu *cMapItem = createMenuItem<ColourMenu>("Colour Schemes");
 		cMapItem->module = scope;
 		menu->addChild(cMapItem);
@@ -425,6 +1032,20 @@ struct PolyScopeWidget : ModuleWidget {
 		pathItem->module = scope;
 		menu->addChild(pathItem);
 
+		menu->addChild(construct<MenuLabel>());
+
+		TriggerChannelMenu *channelItem = createMenuItem<TriggerChannelMenu>("Trigger channel");
+		channelItem->module = scope;
+		menu->addChild(channelItem);
+
+		TriggerLevelMenu *levelItem = createMenuItem<TriggerLevelMenu>("Trigger level");
+		levelItem->module = scope;
+		menu->addChild(levelItem);
+
+		TriggerSlopeMenu *slopeItem = createMenuItem<TriggerSlopeMenu>("Trigger slope");
+		slopeItem->module = scope;
+		menu->addChild(slopeItem);
+
 	 }
 
 };
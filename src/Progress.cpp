@@ -516,8 +516,8 @@ struct ProgressWidget : ModuleWidget {
 		if (module != NULL) {
 			gui::StateDisplay *display = createWidget<gui::StateDisplay>(Vec(0, 135));
 			display->module = module;
-			display->box.size = Vec(100, 140);
-			addChild(display);
+			display->box.size = Vec(300, 30);
+			addChild(new gui::DisplayCache(display));
 		}
 
 	}
@@ -20,7 +20,15 @@ void ProgressState::calculateVoltages(int part, int step) {
 
 	music::ChordDefinition &chordDef = knownChords.chords[chordIndex];
 	std::vector<int> &invDef = chordDef.inversions[invIndex].formula;
-	parts[part][step].setVoltages(invDef, offset);
+	music::getVoltsFromChord(invDef.data(), parts[part][step].rootNote, parts[part][step].octave, offset, voltages[part][step], &rng);
+}
+
+void ProgressState::setRootFromMode(int part, int step) {
+	int rootNote;
+	int quality;
+	music::getRootFromMode(mode, key, parts[part][step].modeDegree, &rootNote, &quality);
+	parts[part][step].rootNote = rootNote;
+	parts[part][step].quality = quality;
 }
 
 void ProgressState::update() {
@@ -32,16 +40,10 @@ void ProgressState::update() {
 					parts[currentPart][step].rootNote = parts[currentPart][step].note;
 					break;
 				case ChordMode::MODE:
-					music::getRootFromMode(mode, key, 
-					parts[currentPart][step].modeDegree,
-					&(parts[currentPart][step].rootNote),
-					&(parts[currentPart][step].quality));
+					setRootFromMode(currentPart, step);
 					break;
 				case ChordMode::COERCE:
-					music::getRootFromMode(mode, key, 
-					parts[currentPart][step].modeDegree,
-					&(parts[currentPart][step].rootNote),
-					&(parts[currentPart][step].quality));
+					setRootFromMode(currentPart, step);
 
 					// Force chord
 					switch(parts[currentPart][step].quality) {
@@ -72,6 +74,7 @@ void ProgressState::copyPartFrom(int src) {
 
 	for (int step = 0; step < 8; step++) {
 		parts[currentPart][step] = parts[src][step];
+		std::copy(voltages[src][step], voltages[src][step] + NUM_PITCHES, voltages[currentPart][step]);
 	}
 
 	stateChanged = true;
@@ -86,7 +89,7 @@ bool ProgressState::gateState(int part, int step) {
 }
 
 float *ProgressState::getChordVoltages(int part, int step) {
-	return parts[part][step].outVolts;
+	return voltages[part][step];
 }
 
 ProgressChord *ProgressState::getChord(int part, int step) {
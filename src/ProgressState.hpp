@@ -10,30 +10,49 @@ enum ChordMode {
 	COERCE
 };
 
-struct ProgressChord : music::Chord {
-
-	bool gate;
-	bool dirty;
-	int  note;
+// Editable description of a chord in a step, packed so that a whole part fits in a cache line.
+// The voltages are calculated from this and held separately in ProgressState::voltages
+struct ProgressChord {
+
+	int8_t rootNote;
+	int8_t quality;
+	int8_t chord;
+	int8_t modeDegree;
+	int8_t inversion;
+	int8_t octave;
+	int8_t note;
+	bool gate : 1;
+	bool dirty : 1;
 
 	void reset() {
-		music::Chord::reset();
+		rootNote = 0;
+		quality = 0;
+		chord = 0;
+		modeDegree = 0;
+		inversion = 0;
+		octave = 0;
+		note = 0;
 		gate = true;
 		dirty = true;
-		note = 0;
 	}
 
 };
 
 struct ProgressState {
 
+	const static int NUM_PITCHES = 6;
+	const static int PITCH_STRIDE = 8; // Pad each step to 32 bytes, a power of two, so steps index with a shift
+
 	ChordMode chordMode = ChordMode::NORMAL;  // 0 == Chord, 1 = Mode, 2 = Coerce
 	int offset = 24; 	// Repeated notes in chord and expressed in the chord definition as being transposed 2 octaves lower. 
 						// When played this offset needs to be removed (or the notes removed, or the notes transposed to an octave higher)
 
 	music::KnownChords knownChords;
 
+	digital::Random rng;
+
 	ProgressChord parts[32][8];
+	float voltages[32][8][PITCH_STRIDE] = {};
 
 	ProgressState();
 	json_t *toJson();
@@ -44,6 +63,7 @@ struct ProgressState {
 
 	void toggleGate(int part, int step);
 	bool gateState(int part, int step);
+	void setRootFromMode(int part, int step);
 	void calculateVoltages(int part, int step);
 	float *getChordVoltages(int part, int step);
 	ProgressChord *getChord(int part, int step);
@@ -81,6 +81,9 @@ struct Ruckus : core::AHModule {
 		json_object_set_new(rootJ, "xMutes", xMutesJ);
 		json_object_set_new(rootJ, "yMutes", yMutesJ);
 
+		// random
+		json_object_set_new(rootJ, "random", rng.toJson());
+
 		return rootJ;
 	}
 
@@ -103,6 +106,11 @@ struct Ruckus : core::AHModule {
 					yMute[i] = !!json_integer_value(yMuteJ);
 			}
 		}
+
+		// random
+		json_t *randomJ = json_object_get(rootJ, "random");
+		if (randomJ)
+			rng.fromJson(randomJ);
 	}
 
 	enum ParamType {
@@ -137,14 +145,14 @@ struct Ruckus : core::AHModule {
 		}
 	}
 
-	digital::AHPulseGenerator xGate[4];
-	digital::AHPulseGenerator yGate[4];
+	digital::PulseBank<4> xGate;
+	digital::PulseBank<4> yGate;
 
 	bool xMute[4] = {true, true, true, true};
 	bool yMute[4] = {true, true, true, true};
 
-	rack::dsp::SchmittTrigger xLockTrigger[4];
-	rack::dsp::SchmittTrigger yLockTrigger[4];
+	digital::TriggerBank<4> xLockTrigger;
+	digital::TriggerBank<4> yLockTrigger;
 
 	rack::dsp::SchmittTrigger inTrigger;
 	rack::dsp::SchmittTrigger resetTrigger;
@@ -156,18 +164,32 @@ struct Ruckus : core::AHModule {
 
 	unsigned int beatCounter = 0;
 
+	digital::Random rng;
+	digital::SeedRequest seedRequest;
+
 };
 
 void Ruckus::process(const ProcessArgs &args) {
 
 	AHModule::step();
 
+	seedRequest.apply(rng);
+
+	float xLock[4];
+	float yLock[4];
 	for (int i = 0; i < 4; i++) {
+		xLock[i] = params[XMUTE_PARAM + i].getValue();
+		yLock[i] = params[YMUTE_PARAM + i].getValue();
+	}
+
+	uint32_t xToggled = xLockTrigger.process(xLock);
+	uint32_t yToggled = yLockTrigger.process(yLock);
 
-		if (xLockTrigger[i].process(params[XMUTE_PARAM + i].getValue())) {
+	for (int i = 0; i < 4; i++) {
+		if ((xToggled >> i) & 1) {
 			xMute[i] = !xMute[i];
 		}
-		if (yLockTrigger[i].process(params[YMUTE_PARAM + i].getValue())) {
+		if ((yToggled >> i) & 1) {
 			yMute[i] = !yMute[i];
 		}
 	}
@@ -214,9 +236,9 @@ void Ruckus::process(const ProcessArgs &args) {
 				}
 
 				if (target % division[i] == 0) { 
-					if (random::uniform() < prob[i]) {
-						xGate[x].trigger(digital::TRIGGER);
-						yGate[y].trigger(digital::TRIGGER);
+					if (rng.uniform() < prob[i]) {
+						xGate.trigger(x, digital::TRIGGER);
+						yGate.trigger(y, digital::TRIGGER);
 						state[i] = 2;
 					}
 				}
@@ -249,9 +271,12 @@ void Ruckus::process(const ProcessArgs &args) {
 		}
 	}
 
+	uint32_t xHigh = xGate.process(args.sampleTime);
+	uint32_t yHigh = yGate.process(args.sampleTime);
+
 	for (int i = 0; i < 4; i++) {
 
-		if (xGate[i].process(args.sampleTime) && xMute[i]) {
+		if (((xHigh >> i) & 1) && xMute[i]) {
 			outputs[XOUT_OUTPUT + i].setVoltage(10.0f);		
 		} else {
 			outputs[XOUT_OUTPUT + i].setVoltage(0.0f);		
@@ -259,7 +284,7 @@ void Ruckus::process(const ProcessArgs &args) {
 
 		lights[XMUTE_LIGHT + i].setBrightness(xMute[i] ? 1.0 : 0.0);
 
-		if (yGate[i].process(args.sampleTime) && yMute[i]) {
+		if (((yHigh >> i) & 1) && yMute[i]) {
 			outputs[YOUT_OUTPUT + i].setVoltage(10.0f);		
 		} else {
 			outputs[YOUT_OUTPUT + i].setVoltage(0.0f);		
@@ -338,11 +363,24 @@ struct RuckusWidget : ModuleWidget {
 		if (module != NULL) {
 			gui::StateDisplay *display = createWidget<gui::StateDisplay>(Vec(30, 335));
 			display->module = module;
-			display->box.size = Vec(100, 140);
-			addChild(display);
+			display->box.size = Vec(300, 30);
+			addChild(new gui::DisplayCache(display));
 		}
 
 	}
+
+	void appendContextMenu(Menu *menu) override {
+
+		Ruckus *ruckus = dynamic_cast<Ruckus*>(module);
+		assert(ruckus);
+
+		menu->addChild(construct<MenuLabel>());
+		gui::SeedMenu *seedItem = createMenuItem<gui::SeedMenu>("Random seed");
+		seedItem->rng = &(ruckus->rng);
+		seedItem->request = &(ruckus->seedRequest);
+		menu->addChild(seedItem);
+
+	}
 };
 
 Model *modelRuckus = createModel<Ruckus, RuckusWidget>("Ruckus");
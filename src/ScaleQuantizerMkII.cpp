@@ -45,26 +45,105 @@ struct ScaleQuantizer2 : core::AHModule {
 			configParam(SHIFT_PARAM + i, -3.0f, 3.0f, 0.0f, "Octave shift", " octaves");
 		}
 
+		invalidateQuantiser();
+		music::scaleRegistry.load();
+
+	}
+
+	json_t *dataToJson() override {
+		json_t *rootJ = json_object();
+
+		// user scale
+		if (userScalePending) {
+			json_object_set_new(rootJ, "userScale", json_string(userScaleName.c_str()));
+		} else if (userScale >= 0) {
+			json_object_set_new(rootJ, "userScale", json_string(music::scaleRegistry.get(userScale).name.c_str()));
+		}
+
+		return rootJ;
+	}
+
+	void dataFromJson(json_t *rootJ) override {
+
+		// user scale
+		json_t *userScaleJ = json_object_get(rootJ, "userScale");
+		if (json_is_string(userScaleJ)) {
+			userScaleName = json_string_value(userScaleJ);
+			userScale = -1;
+			userScalePending = true;
+		}
+
+	}
+
+	// Quantise with the user scale if one is selected, otherwise the built-in scale
+	float quantise(float v) {
+		if (currUserScale >= 0) {
+			return music::scaleRegistry.get(currUserScale).quantise(v, currRoot);
+		} else {
+			return music::getPitchFromVolts(v, currRoot, currScale);
+		}
 	}
 
 	void process(const ProcessArgs &args) override;
 
+	// Forget the last quantised input, NaN never compares equal so every channel is quantised again
+	void invalidateQuantiser() {
+		std::fill(&lastInput[0][0], &lastInput[0][0] + 8 * 16, NAN);
+	}
+
 	bool firstStep = true;
 	int lastScale = 0;
 	int lastRoot = 0;
 	float lastTrans = -10000.0f;
 
-	dsp::SchmittTrigger holdTrigger[8][16];
-	dsp::PulseGenerator triggerPulse[8][16];
+	digital::TriggerBank<16> holdTrigger[8];
+	digital::PulseBank<16> triggerPulse[8];
 
 	float holdPitch[8][16] = {};
 	float lastPitch[8][16] = {};
 
-	bool holdState[8][16];
+	// Input voltage that holdPitch was quantised from, so that steady CV is not quantised again
+	float lastInput[8][16];
+
+	// How a row samples its CV depends on what is connected to it. Each combination is its own instance of processRow,
+	// chosen when the connections change, so the per-channel loop does not have to decide
+	enum HoldMode {
+		HOLD_NONE,			// No hold input, track the CV
+		HOLD_COMMON,		// Mono hold, channel 0 samples all channels
+		HOLD_CHANNEL,		// Poly hold, each channel samples its own CV
+		HOLD_CHANNEL_MONO	// Poly hold and mono CV, each channel samples channel 0 of the CV
+	};
+
+	typedef void (ScaleQuantizer2::*RowFunc)(int row, int nChannels, uint32_t held, float offset);
+	RowFunc rowFunc[8] = {};
+	int rowTopology[8] = {-1, -1, -1, -1, -1, -1, -1, -1};
+
+	template <HoldMode MODE>
+	void processRow(int row, int nChannels, uint32_t held, float offset);
+
+	static RowFunc selectRow(int nCVChannels, int nHoldChannels) {
+		if (nHoldChannels == 0) {
+			return &ScaleQuantizer2::processRow<HOLD_NONE>;
+		} else if (nHoldChannels == 1) {
+			return &ScaleQuantizer2::processRow<HOLD_COMMON>;
+		} else if (nCVChannels == 1) {
+			return &ScaleQuantizer2::processRow<HOLD_CHANNEL_MONO>;
+		} else {
+			return &ScaleQuantizer2::processRow<HOLD_CHANNEL>;
+		}
+	}
 
 	int currScale = 0;
 	int currRoot = 0;
 
+	int userScale = -1; // Index into music::scaleRegistry, overrides the scale knob
+	int currUserScale = -1;
+	int lastUserScale = -1;
+
+	// Saved scale, looked up once the registry has finished loading
+	std::string userScaleName;
+	std::atomic<bool> userScalePending {false};
+
 };
 
 void ScaleQuantizer2::process(const ProcessArgs &args) {
@@ -73,6 +152,13 @@ void ScaleQuantizer2::process(const ProcessArgs &args) {
 
 	lastScale = currScale;
 	lastRoot = currRoot;
+	if (userScalePending && music::scaleRegistry.isLoaded()) {
+		userScale = music::scaleRegistry.find(userScaleName);
+		userScalePending = false;
+	}
+
+	lastUserScale = currUserScale;
+	currUserScale = userScale;
 
 	if (inputs[KEY_INPUT].isConnected()) {
 		currRoot = music::getKeyFromVolts(inputs[KEY_INPUT].getVoltage());
@@ -86,6 +172,11 @@ void ScaleQuantizer2::process(const ProcessArgs &args) {
 		currScale = params[SCALE_PARAM].getValue();
 	}
 
+	// Transposition is added after quantisation, so only the key and scale matter here
+	if (currRoot != lastRoot || currScale != lastScale || currUserScale != lastUserScale) {
+		invalidateQuantiser();
+	}
+
 	float trans = (inputs[TRANS_INPUT].getVoltage() + params[TRANS_PARAM].getValue()) / 12.0;
 	if (trans != 0.0) {
 		if (trans != lastTrans) {
@@ -105,55 +196,28 @@ void ScaleQuantizer2::process(const ProcessArgs &args) {
 		outputs[OUT_OUTPUT + i].setChannels(nChannels);
 		outputs[TRIG_OUTPUT + i].setChannels(nChannels);
 
-		for (int j = 0; j < nChannels; j++) {
-
-			holdState[i][j] = holdTrigger[i][j].process(inputs[HOLD_INPUT + i].getVoltage(j));
-
-			if (nHoldChannels == 0) {
-				holdPitch[i][j] = music::getPitchFromVolts(inputs[IN_INPUT + i].getVoltage(j), currRoot, currScale);
-			} else if (nHoldChannels == 1) {
-				if (holdState[i][0]) { // Use channel 0 for hold
-					holdPitch[i][j] = music::getPitchFromVolts(inputs[IN_INPUT + i].getVoltage(j), currRoot, currScale);
-				}
-			} else {
-				if (nCVChannels == 1) {
-					if (holdState[i][j]) {
-						holdPitch[i][j] = music::getPitchFromVolts(inputs[IN_INPUT + i].getVoltage(0), currRoot, currScale); // (re)-sample channel 0
-					}
-				} else {
-					if (holdState[i][j]) {
-						holdPitch[i][j] = music::getPitchFromVolts(inputs[IN_INPUT + i].getVoltage(j), currRoot, currScale);
-					}
-				}
-			}
-
-			// If the quantised pitch has changed
-			if (lastPitch[i][j] != holdPitch[i][j]) {
-
-				// Record the pitch
-				lastPitch[i][j] = holdPitch[i][j];
-
-				// Pulse the gate
-				triggerPulse[i][j].trigger(digital::TRIGGER);
-			} 
-
-			outputs[OUT_OUTPUT + i].setVoltage(holdPitch[i][j] + shift + trans, j);
-
-			if (triggerPulse[i][j].process(args.sampleTime)) {
-				outputs[TRIG_OUTPUT + i].setVoltage(10.0f, j);
-			} else {
-				outputs[TRIG_OUTPUT + i].setVoltage(0.0f, j);
-			}
+		uint32_t held = holdTrigger[i].process(inputs[HOLD_INPUT + i].getVoltages());
 
+		int topology = nCVChannels * (PORT_MAX_CHANNELS + 1) + nHoldChannels;
+		if (topology != rowTopology[i]) {
+			rowTopology[i] = topology;
+			rowFunc[i] = selectRow(nCVChannels, nHoldChannels);
 		}
 
+		(this->*rowFunc[i])(i, nChannels, held, shift + trans);
+
+		triggerPulse[i].processLong(args.sampleTime); // Same length as the dsp::PulseGenerator it replaced
+		triggerPulse[i].store(outputs[TRIG_OUTPUT + i].getVoltages(), 10.0f);
+
 	}
 
-	if (lastScale != currScale || firstStep) {
+	if (lastScale != currScale || lastUserScale != currUserScale || firstStep) {
 		for (int i = 0; i < music::NUM_NOTES; i++) {
 			lights[SCALE_LIGHT + i].setBrightness(0.0f);
 		}
-		lights[SCALE_LIGHT + currScale].setBrightness(10.0f);
+		if (currUserScale < 0) {
+			lights[SCALE_LIGHT + currScale].setBrightness(10.0f);
+		}
 	} 
 
 	if (lastRoot != currRoot || firstStep) {
@@ -167,6 +231,43 @@ void ScaleQuantizer2::process(const ProcessArgs &args) {
 
 }
 
+template <ScaleQuantizer2::HoldMode MODE>
+void ScaleQuantizer2::processRow(int row, int nChannels, uint32_t held, float offset) {
+
+	const float *in = inputs[IN_INPUT + row].getVoltages();
+	float *out = outputs[OUT_OUTPUT + row].getVoltages();
+
+	for (int j = 0; j < nChannels; j++) {
+
+		bool sample;
+		switch (MODE) {
+			case HOLD_NONE:		sample = true; break;
+			case HOLD_COMMON:	sample = held & 1; break;
+			default:			sample = (held >> j) & 1;
+		}
+
+		float v = in[MODE == HOLD_CHANNEL_MONO ? 0 : j];
+		if (sample && v != lastInput[row][j]) {
+			lastInput[row][j] = v;
+			holdPitch[row][j] = quantise(v);
+		}
+
+		// If the quantised pitch has changed
+		if (lastPitch[row][j] != holdPitch[row][j]) {
+
+			// Record the pitch
+			lastPitch[row][j] = holdPitch[row][j];
+
+			// Pulse the gate
+			triggerPulse[row].trigger(j, digital::TRIGGER);
+		} 
+
+		out[j] = holdPitch[row][j] + offset;
+
+	}
+
+}
+
 struct ScaleQuantizer2Widget : ModuleWidget {
 
 	ScaleQuantizer2Widget(ScaleQuantizer2 *module) {
@@ -204,6 +305,19 @@ struct ScaleQuantizer2Widget : ModuleWidget {
 
 	}
 
+	void appendContextMenu(Menu *menu) override {
+
+		ScaleQuantizer2 *quant = dynamic_cast<ScaleQuantizer2*>(module);
+		assert(quant);
+
+		menu->addChild(construct<MenuLabel>());
+		gui::UserScaleMenu *scaleItem = createMenuItem<gui::UserScaleMenu>("User scale");
+		scaleItem->userScale = &(quant->userScale);
+		scaleItem->noneName = "None (use Scale knob)";
+		menu->addChild(scaleItem);
+
+	}
+
 };
 
 Model *modelScaleQuantizer2 = createModel<ScaleQuantizer2, ScaleQuantizer2Widget>("ScaleQuantizer2");